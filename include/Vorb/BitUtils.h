@@ -0,0 +1,53 @@
+//
+// BitUtils.h
+// Vorb Engine
+//
+// Created by agent on 17 Oct 2026
+// Copyright 2014 Regrowth Studios
+// All Rights Reserved
+//
+
+/*! \file BitUtils.h
+ * @brief Bit scanning helpers shared by bitmask based containers and algorithms.
+ */
+
+#pragma once
+
+#ifndef Vorb_BitUtils_h__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_BitUtils_h__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include "types.h"
+#endif // !VORB_USING_PCH
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace vorb {
+    /*! @brief Finds the lowest set bit of a bitmask.
+     *
+     * @param v: Non-zero value
+     * @return Index of the lowest set bit
+     */
+    inline ui32 lowestSetBit(ui64 v) {
+#if defined(_MSC_VER) && defined(_WIN64)
+        unsigned long i;
+        _BitScanForward64(&i, v);
+        return i;
+#elif defined(__GNUC__)
+        return __builtin_ctzll(v);
+#else
+        ui32 i = 0;
+        while ((v & 1) == 0) {
+            v >>= 1;
+            i++;
+        }
+        return i;
+#endif
+    }
+}
+
+#endif // !Vorb_BitUtils_h__
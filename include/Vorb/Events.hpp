@@ -319,6 +319,11 @@ public:
     Event& operator -=(const Listener& f) {
         return remove(f);
     }
+
+    /// @return Number of bound functions
+    size_t getListenerCount() const {
+        return m_funcs.size();
+    }
 private:
     Sender m_sender; ///< Event owner
     std::vector<Listener> m_funcs; ///< List of bound functions (subscribers)
@@ -9,13 +9,31 @@
 /// Summary:
 /// This class will recycle fixed sized arrays of a specific type.
 /// This is very useful for chunk data but may have other uses.
+/// SizeClassArrayRecycler does the same for several sizes at once
+/// and may be shared between threads.
 
 #pragma once
 
 #ifndef FixedSizeArrayRecycler_h__
 #define FixedSizeArrayRecycler_h__
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "compat.h"
+#include "concurrentqueue.h"
+
+// compat.h defines OS_WINDOWS and brings in the VirtualAlloc declarations
+#if !defined(OS_WINDOWS)
+#include <cstdlib>
+#include <sys/mman.h>
+#endif
 
 namespace vorb {
     namespace core {
@@ -72,6 +90,226 @@ namespace vorb {
             ui32 _maxSize; ///< Maximum number of arrays to hold
             std::vector<T*> _arrays; ///< Stack of recycled array data
         };
+
+        /// How a SizeClassArrayRecycler obtains array memory
+        enum class ArrayBacking {
+            HEAP, ///< Plain operator new
+            ALIGNED, ///< Aligned to the system page size (4 KiB)
+            HUGE_PAGES ///< Large pages where the OS allows it, otherwise page aligned
+        };
+
+        /// Counters of a SizeClassArrayRecycler
+        struct ArrayRecyclerStats {
+        public:
+            ui64 hits = 0; ///< Arrays served from a free list
+            ui64 misses = 0; ///< Arrays that had to be allocated
+            ui64 trimmed = 0; ///< Arrays freed to stay within the byte budget
+            size_t bytesHeld = 0; ///< Bytes currently sitting in free lists
+        };
+
+        /// Recycles arrays of several sizes from many threads.
+        /// Each size class has a lock free free list. The free lists share a byte budget;
+        /// when it is exceeded, the least recently used classes are trimmed first,
+        /// oldest arrays first. T must be a POD type, arrays are not constructed.
+        template<typename T>
+        class SizeClassArrayRecycler {
+        public:
+            /// Constructor
+            /// @param sizeClasses: Element counts of the cached arrays
+            /// @param byteBudget: Maximum bytes held by all free lists together
+            /// @param backing: How array memory is allocated
+            SizeClassArrayRecycler(std::vector<size_t> sizeClasses, size_t byteBudget, ArrayBacking backing = ArrayBacking::HEAP) :
+                m_byteBudget(byteBudget),
+                m_backing(backing) {
+                static_assert(std::is_trivially_destructible<T>::value, "Recycled arrays must hold POD data");
+                std::sort(sizeClasses.begin(), sizeClasses.end());
+                sizeClasses.erase(std::unique(sizeClasses.begin(), sizeClasses.end()), sizeClasses.end());
+                for (auto& elements : sizeClasses) {
+                    m_classes.emplace_back(new SizeClass);
+                    m_classes.back()->elements = elements;
+                    m_classes.back()->bytes = elements * sizeof(T);
+                }
+            }
+            ~SizeClassArrayRecycler() { destroy(); }
+
+            /// Frees all cached arrays
+            void destroy() {
+                for (auto& sc : m_classes) {
+                    T* data;
+                    while (sc->arrays.try_dequeue(data)) {
+                        freeArray(data, sc->bytes);
+                        m_bytesHeld.fetch_sub((i64)sc->bytes, std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            /// Gets an array with room for at least n elements. May allocate new memory
+            /// @param n: Number of elements needed
+            /// @return Pointer to the array, rounded up to the smallest fitting size class
+            T* create(size_t n) {
+                SizeClass* sc = getClass(n);
+                if (!sc) return allocateArray(n * sizeof(T));
+
+                T* rv;
+                if (sc->arrays.try_dequeue(rv)) {
+                    m_bytesHeld.fetch_sub((i64)sc->bytes, std::memory_order_relaxed);
+                    sc->hits.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    rv = allocateArray(sc->bytes);
+                    sc->misses.fetch_add(1, std::memory_order_relaxed);
+                }
+                sc->lastUse.store(now(), std::memory_order_relaxed);
+                return rv;
+            }
+
+            /// Recycles an array obtained from create().
+            /// Does not check for double recycles, so be careful.
+            /// @param data: The array, which should no longer be used
+            /// @param n: The element count that was passed to create()
+            void recycle(T* data, size_t n) {
+                SizeClass* sc = getClass(n);
+                if (!sc) {
+                    freeArray(data, n * sizeof(T));
+                    return;
+                }
+
+                // Count the bytes before the array becomes visible, so that a create()
+                // that dequeues it can never subtract them first
+                i64 held = m_bytesHeld.fetch_add((i64)sc->bytes, std::memory_order_relaxed) + (i64)sc->bytes;
+                sc->arrays.enqueue(data);
+                sc->lastUse.store(now(), std::memory_order_relaxed);
+                if (held > (i64)m_byteBudget) trim(m_byteBudget);
+            }
+
+            /// Frees cached arrays, least recently used classes first, until the
+            /// held bytes are within a target. Returns immediately if another thread is trimming.
+            /// @param targetBytes: Bytes that may remain held
+            void trim(size_t targetBytes) {
+                if (m_isTrimming.test_and_set(std::memory_order_acquire)) return;
+
+                while (getBytesHeld() > targetBytes) {
+                    // Find the least recently used class that still holds arrays
+                    SizeClass* victim = nullptr;
+                    for (auto& sc : m_classes) {
+                        if (sc->arrays.size_approx() == 0) continue;
+                        if (!victim || sc->lastUse.load(std::memory_order_relaxed) < victim->lastUse.load(std::memory_order_relaxed)) {
+                            victim = sc.get();
+                        }
+                    }
+                    T* data;
+                    if (!victim || !victim->arrays.try_dequeue(data)) break;
+
+                    freeArray(data, victim->bytes);
+                    m_bytesHeld.fetch_sub((i64)victim->bytes, std::memory_order_relaxed);
+                    victim->trimmed.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                m_isTrimming.clear(std::memory_order_release);
+            }
+
+            /// @return Counters summed over all size classes
+            ArrayRecyclerStats getStats() const {
+                ArrayRecyclerStats stats;
+                for (auto& sc : m_classes) {
+                    stats.hits += sc->hits.load(std::memory_order_relaxed);
+                    stats.misses += sc->misses.load(std::memory_order_relaxed);
+                    stats.trimmed += sc->trimmed.load(std::memory_order_relaxed);
+                }
+                stats.bytesHeld = getBytesHeld();
+                return stats;
+            }
+
+            /// Setters
+            void setByteBudget(size_t byteBudget) {
+                m_byteBudget = byteBudget;
+                trim(m_byteBudget);
+            }
+
+            /// Getters
+            size_t getBytesHeld() const {
+                i64 held = m_bytesHeld.load(std::memory_order_relaxed);
+                return held > 0 ? (size_t)held : 0;
+            }
+            const size_t& getByteBudget() const { return m_byteBudget; }
+            size_t getNumSizeClasses() const { return m_classes.size(); }
+            size_t getSizeClass(size_t i) const { return m_classes[i]->elements; }
+        private:
+            VORB_NON_COPYABLE(SizeClassArrayRecycler);
+
+            /// Free list and counters of one array size
+            struct SizeClass {
+            public:
+                size_t elements; ///< Elements per array
+                size_t bytes; ///< Bytes per array
+                moodycamel::ConcurrentQueue<T*> arrays; ///< Free arrays, oldest first
+                std::atomic<i64> lastUse = ATOMIC_VAR_INIT(0); ///< Time of the last create or recycle
+                std::atomic<ui64> hits = ATOMIC_VAR_INIT(0); ///< Arrays served from the free list
+                std::atomic<ui64> misses = ATOMIC_VAR_INIT(0); ///< Arrays that were allocated
+                std::atomic<ui64> trimmed = ATOMIC_VAR_INIT(0); ///< Arrays freed by trim()
+                ui8 padding[64]; ///< Keeps counters of neighbouring classes apart
+            };
+
+            /// @param n: Element count
+            /// @return Smallest class that fits n elements, or nullptr
+            SizeClass* getClass(size_t n) const {
+                auto it = std::lower_bound(m_classes.begin(), m_classes.end(), n, [] (const std::unique_ptr<SizeClass>& sc, size_t elements) {
+                    return sc->elements < elements;
+                });
+                return it == m_classes.end() ? nullptr : it->get();
+            }
+
+            static i64 now() {
+                return (i64)std::chrono::steady_clock::now().time_since_epoch().count();
+            }
+
+            /// Allocates array memory according to the backing
+            /// @param bytes: Size of the array
+            T* allocateArray(size_t bytes) {
+                if (m_backing == ArrayBacking::HEAP) return (T*)operator new(bytes);
+#if defined(OS_WINDOWS)
+                if (m_backing == ArrayBacking::HUGE_PAGES) {
+                    size_t large = GetLargePageMinimum();
+                    if (large > 0 && bytes % large == 0) {
+                        void* mem = VirtualAlloc(nullptr, bytes, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+                        if (mem) return (T*)mem;
+                    }
+                }
+                void* mem = VirtualAlloc(nullptr, bytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+                if (!mem) throw std::bad_alloc();
+                return (T*)mem;
+#else
+                const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+                bool huge = m_backing == ArrayBacking::HUGE_PAGES && bytes >= HUGE_PAGE_SIZE;
+                void* mem = nullptr;
+                if (posix_memalign(&mem, huge ? HUGE_PAGE_SIZE : 4096, bytes) != 0) throw std::bad_alloc();
+#if defined(MADV_HUGEPAGE)
+                // Transparent huge pages are only a hint
+                if (huge) madvise(mem, bytes, MADV_HUGEPAGE);
+#endif
+                return (T*)mem;
+#endif
+            }
+            /// Frees memory obtained from allocateArray
+            /// @param data: The array
+            /// @param bytes: Size of the array
+            void freeArray(T* data, size_t bytes) {
+                if (m_backing == ArrayBacking::HEAP) {
+                    operator delete(data);
+                    return;
+                }
+#if defined(OS_WINDOWS)
+                VirtualFree(data, 0, MEM_RELEASE);
+#else
+                free(data);
+#endif
+            }
+
+            std::vector<std::unique_ptr<SizeClass> > m_classes; ///< Size classes sorted by element count
+            std::atomic<i64> m_bytesHeld = ATOMIC_VAR_INIT(0); ///< Bytes in all free lists, signed so a race can never wrap it
+            size_t m_byteBudget; ///< Maximum value of m_bytesHeld
+            ArrayBacking m_backing; ///< How memory is obtained
+            std::atomic_flag m_isTrimming = ATOMIC_FLAG_INIT; ///< Allows one trimming thread at a time
+        };
     }
 }
 namespace vcore = vorb::core;
@@ -15,17 +15,46 @@
 #ifndef ThreadPoolTask_h__
 #define ThreadPoolTask_h__
 
+#include <atomic>
+#include <chrono>
+#include <vector>
+
 namespace vorb {
     namespace core {
+        /// Scheduling lane of a task. Workers drain higher lanes first.
+        enum class TaskPriority : ui8 {
+            LOW = 0, ///< Background work (far chunk generation, saving)
+            NORMAL = 1, ///< Default lane
+            HIGH = 2 ///< Latency sensitive work (meshes near the camera)
+        };
+        const size_t NUM_TASK_PRIORITIES = 3; ///< Number of lanes in a ThreadPool
+
+        template<typename T> class IThreadPoolTask;
+
+        /// Receives finished tasks that are not stored in a finished tasks queue
+        template<typename T>
+        class ITaskRecycler {
+        public:
+            virtual ~ITaskRecycler() { /* Empty */ }
+
+            /// Takes back a task that will not be used anymore
+            /// @param task: The finished task
+            /// @param workerIndex: Index of the recycling worker, or -1 if not called from a worker
+            virtual void recycle(IThreadPoolTask<T>* task, i32 workerIndex = -1) = 0;
+        };
 
         template<typename T>
         class IThreadPoolTask {
         public:
+            typedef std::chrono::high_resolution_clock Clock;
+
             /// Constructor
             /// @param taskId: Optional unique identifier for task type.
-            IThreadPoolTask(bool shouldAddToFinishedTasks = false, i32 taskId = -1) :
+            /// @param priority: Lane the task is scheduled in
+            IThreadPoolTask(bool shouldAddToFinishedTasks = false, i32 taskId = -1, TaskPriority priority = TaskPriority::NORMAL) :
                 m_shouldAddToFinishedTasks(shouldAddToFinishedTasks),
-                m_taskId(taskId) {
+                m_taskId(taskId),
+                m_priority(priority) {
                 /* Empty */
             }
 
@@ -40,15 +69,65 @@ namespace vorb {
             /// Setters
             void setIsFinished(bool isFinished) { m_isFinished = isFinished; }
             void setShouldAddToFinishedtasks(bool shouldAdd) { m_shouldAddToFinishedTasks = shouldAdd; }
+            void setPriority(TaskPriority priority) { m_priority = priority; }
+            /// Tasks with a deadline are dequeued earliest-deadline-first once it draws near,
+            /// regardless of their priority lane
+            /// @param deadline: Time by which the task should have started
+            void setDeadline(const Clock::time_point& deadline) { m_deadline = deadline; m_hasDeadline = true; }
+            void clearDeadline() { m_hasDeadline = false; }
+            /// Set by the ThreadPool when the task is submitted
+            void setSubmitTime(const Clock::time_point& time) { m_submitTime = time; }
+            /// Tasks with a recycler are handed back to it by the worker once finished,
+            /// unless they should be added to the finished tasks queue
+            void setRecycler(ITaskRecycler<T>* recycler) { m_recycler = recycler; }
+
+            /// Schedules a task to be enqueued by the worker that completes its last dependency.
+            /// Must be called before this task is submitted. Only tasks without pending
+            /// dependencies should be added to a ThreadPool; successors are enqueued automatically.
+            /// @param successor: Task that must wait for this one
+            void addContinuation(IThreadPoolTask<T>* successor) {
+                successor->m_pendingDependencies.fetch_add(1, std::memory_order_relaxed);
+                m_continuations.push_back(successor);
+            }
+            /// Makes this task wait for another one
+            /// @param predecessor: Task that must finish first
+            void addDependency(IThreadPoolTask<T>* predecessor) {
+                predecessor->addContinuation(this);
+            }
+            /// Called by the ThreadPool after execution. Continuations are one-shot and are
+            /// cleared so the task can be reused.
+            /// @param ready: Receives successors whose last dependency was this task
+            void releaseContinuations(OUT std::vector<IThreadPoolTask<T>*>& ready) {
+                for (auto& successor : m_continuations) {
+                    if (successor->m_pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        ready.push_back(successor);
+                    }
+                }
+                m_continuations.clear();
+            }
 
             /// Getters
             const i32& getTaskId() const { return m_taskId; }
             const volatile bool& getIsFinished() const { return m_isFinished; }
+            const TaskPriority& getPriority() const { return m_priority; }
+            const bool& hasDeadline() const { return m_hasDeadline; }
+            const Clock::time_point& getDeadline() const { return m_deadline; }
+            const Clock::time_point& getSubmitTime() const { return m_submitTime; }
+            i32 getPendingDependencies() const { return m_pendingDependencies.load(std::memory_order_acquire); }
+            bool hasContinuations() const { return !m_continuations.empty(); }
+            ITaskRecycler<T>* getRecycler() const { return m_recycler; }
 
         protected:
             i32 m_taskId;
             volatile bool m_isFinished = false;
             bool m_shouldAddToFinishedTasks; ///< SHould it be stored in a finished tasks queue
+            TaskPriority m_priority; ///< Lane this task is scheduled in
+            bool m_hasDeadline = false; ///< True if m_deadline is valid
+            Clock::time_point m_deadline; ///< Time by which the task should have started
+            Clock::time_point m_submitTime; ///< Time the task was added to a pool, used for latency tracking
+            std::atomic<i32> m_pendingDependencies = ATOMIC_VAR_INIT(0); ///< Predecessors that have not finished
+            std::vector<IThreadPoolTask<T>*> m_continuations; ///< Successors waiting on this task
+            ITaskRecycler<T>* m_recycler = nullptr; ///< Owner of this task's memory, if pooled
         };
     }
 }
@@ -0,0 +1,261 @@
+//
+// ParallelFor.hpp
+// Vorb Engine
+//
+// Created by agent on 17 Oct 2026
+// Copyright 2014 Regrowth Studios
+// All Rights Reserved
+//
+
+/*! \file ParallelFor.hpp
+ * @brief Data-parallel loops executed on a ThreadPool.
+ */
+
+#pragma once
+
+#ifndef Vorb_ParallelFor_hpp__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_ParallelFor_hpp__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "types.h"
+#endif // !VORB_USING_PCH
+
+#include "ThreadPool.h"
+
+namespace vorb {
+    namespace core {
+        namespace impl {
+            /*! @brief Shared state of one parallel loop.
+             *
+             * Participants claim chunks from an atomic cursor. Chunks start large and shrink
+             * towards the grain as the range drains, so late participants still find work.
+             * The job owns its helper tasks and frees itself once the caller and every helper
+             * have let go of it; helpers that start after the range is exhausted never touch
+             * the loop body.
+             */
+            template<typename T, typename Body>
+            class ParallelJob : public ITaskRecycler<T> {
+            public:
+                /*! @brief Task that runs the loop on a worker.
+                 */
+                class HelperTask : public IThreadPoolTask<T> {
+                public:
+                    HelperTask() : IThreadPoolTask<T>(false, -1, TaskPriority::HIGH) {
+                        // Empty
+                    }
+                    virtual void execute(T* workerData) override {
+                        job->run(workerData, slot);
+                    }
+
+                    ParallelJob* job = nullptr; ///< Owner
+                    size_t slot = 0; ///< Participant index passed to the body
+                };
+
+                /*! @param begin: First index of the range
+                 * @param end: One past the last index of the range
+                 * @param grain: Smallest chunk handed to a participant
+                 * @param numHelpers: Number of helper tasks to create
+                 * @param body: Loop body, must outlive the loop
+                 */
+                ParallelJob(size_t begin, size_t end, size_t grain, size_t numHelpers, const Body* body) :
+                    m_next(begin),
+                    m_end(end),
+                    m_total(end - begin),
+                    m_grain(grain > 0 ? grain : 1),
+                    m_participants(numHelpers + 1),
+                    m_refs((ui32)numHelpers + 1),
+                    m_body(body),
+                    helpers(numHelpers) {
+                    for (size_t i = 0; i < numHelpers; i++) {
+                        helpers[i].job = this;
+                        helpers[i].slot = i;
+                        helpers[i].setRecycler(this);
+                    }
+                }
+
+                /*! @brief Executes chunks until the range is exhausted.
+                 *
+                 * @param data: Scratch data of the participant
+                 * @param slot: Participant index
+                 */
+                void run(T* data, size_t slot) {
+                    size_t start, stop;
+                    while (claim(start, stop)) {
+                        (*m_body)(start, stop, data, slot);
+                        m_completed.fetch_add(stop - start, std::memory_order_release);
+                    }
+                }
+
+                /// @return True once every index has been processed
+                bool isComplete() const {
+                    return m_completed.load(std::memory_order_acquire) == m_total;
+                }
+
+                /*! @brief Called by the worker once a helper is done with the job.
+                 */
+                virtual void recycle(IThreadPoolTask<T>* task, i32 workerIndex = -1) override {
+                    release();
+                }
+                /*! @brief Drops a reference, deleting the job after the last one.
+                 */
+                void release() {
+                    if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+                }
+
+            private:
+                VORB_NON_COPYABLE(ParallelJob);
+
+                /*! @brief Claims the next chunk of the range.
+                 *
+                 * @param start: First index of the chunk
+                 * @param stop: One past the last index of the chunk
+                 * @return False if the range is exhausted
+                 */
+                bool claim(OUT size_t& start, OUT size_t& stop) {
+                    size_t cur = m_next.load(std::memory_order_relaxed);
+                    while (cur < m_end) {
+                        size_t remaining = m_end - cur;
+                        size_t size = remaining / (m_participants * 2);
+                        if (size < m_grain) size = m_grain;
+                        if (size > remaining) size = remaining;
+                        if (m_next.compare_exchange_weak(cur, cur + size, std::memory_order_relaxed)) {
+                            start = cur;
+                            stop = cur + size;
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                std::atomic<size_t> m_next; ///< First unclaimed index
+                std::atomic<size_t> m_completed = ATOMIC_VAR_INIT(0); ///< Number of processed indices
+                size_t m_end; ///< End of the range
+                size_t m_total; ///< Number of indices in the range
+                size_t m_grain; ///< Minimum chunk size
+                size_t m_participants; ///< Helpers plus the caller
+                std::atomic<ui32> m_refs; ///< Caller plus helpers that have not finished
+                const Body* m_body; ///< Loop body
+            public:
+                std::vector<HelperTask> helpers; ///< Tasks submitted to the pool
+            };
+
+            /*! @brief Splits a range across the pool and the calling thread.
+             *
+             * The caller always claims chunks until the range is exhausted, so the loop finishes
+             * even if no helper ever runs, for example when every worker is blocked in a nested
+             * loop or clearTasks() dropped the helpers. Dropped helpers never claimed a chunk, so
+             * the caller only waits for chunks that are executing elsewhere.
+             *
+             * @param body: Callable as body(start, end, T* data, size_t slot)
+             * @param callerData: Scratch for the caller. If null, a value-initialized T is used.
+             * @param callerSlot: Slot passed to the body when the caller executes a chunk
+             */
+            template<typename T, typename Body>
+            void runParallel(ThreadPool<T>& pool, size_t begin, size_t end, size_t grain, const Body& body, T* callerData, size_t callerSlot) {
+                if (end <= begin) return;
+                if (grain == 0) grain = 1;
+                // Only build scratch for the caller when it brought none
+                std::unique_ptr<T> localData;
+                if (!callerData) {
+                    localData.reset(new T());
+                    callerData = localData.get();
+                }
+
+                // Never spawn more helpers than there are chunks to go around
+                size_t chunks = (end - begin + grain - 1) / grain;
+                size_t numHelpers = (size_t)pool.getNumWorkers();
+                if (numHelpers > chunks - 1) numHelpers = chunks - 1;
+                if (numHelpers == 0) {
+                    body(begin, end, callerData, callerSlot);
+                    return;
+                }
+
+                ParallelJob<T, Body>* job = new ParallelJob<T, Body>(begin, end, grain, numHelpers, &body);
+                for (auto& helper : job->helpers) pool.addTask(&helper);
+
+                // Help out, then wait for chunks still running elsewhere
+                job->run(callerData, callerSlot);
+                while (!job->isComplete()) std::this_thread::yield();
+                job->release();
+            }
+
+            /*! @brief Partial result of one participant, padded so that participants
+             * writing neighbouring partials never share a cache line.
+             */
+            template<typename R>
+            struct PaddedPartial {
+            public:
+                PaddedPartial(const R& value) : value(value) {
+                    // Empty
+                }
+
+                R value; ///< Joined chunks of the participant
+                ui8 padding[64]; ///< Keeps the next partial off this line
+            };
+        }
+
+        /*! @brief Runs fn over [begin, end) on the pool's workers and the calling thread.
+         *
+         * The range is split adaptively: chunks start at a fraction of the remaining work and
+         * shrink to the grain as it drains. Each chunk receives the data of the thread that
+         * executes it, which may be used as per-thread scratch space. Helper tasks run in the
+         * HIGH lane, and the call returns once every index has been processed. Safe to call
+         * from a worker of the same pool.
+         *
+         * @tparam T: Worker data type of the pool
+         * @tparam F: Callable as fn(size_t start, size_t end, T* data)
+         * @param pool: Pool whose workers help execute the loop
+         * @param begin: First index
+         * @param end: One past the last index
+         * @param grain: Smallest number of indices handed out at once
+         * @param fn: Loop body
+         * @param callerData: Scratch for the calling thread. If null, a value-initialized T is used.
+         */
+        template<typename T, typename F>
+        void parallelFor(ThreadPool<T>& pool, size_t begin, size_t end, size_t grain, F fn, OPT T* callerData = nullptr) {
+            auto body = [&fn] (size_t start, size_t stop, T* data, size_t slot) {
+                fn(start, stop, data);
+            };
+            impl::runParallel(pool, begin, end, grain, body, callerData, 0);
+        }
+
+        /*! @brief Maps chunks of [begin, end) to values and joins them.
+         *
+         * Splits like parallelFor. Each participant joins its chunks into a private partial,
+         * and the partials are joined on the calling thread, so join must be associative and
+         * commutative.
+         *
+         * @tparam T: Worker data type of the pool
+         * @tparam R: Result type
+         * @tparam Map: Callable as R map(size_t start, size_t end, T* data)
+         * @tparam Join: Callable as R join(const R& a, const R& b)
+         * @param identity: Neutral element of join
+         * @param callerData: Scratch for the calling thread. If null, a value-initialized T is used.
+         * @return The joined result
+         */
+        template<typename T, typename R, typename Map, typename Join>
+        R parallelReduce(ThreadPool<T>& pool, size_t begin, size_t end, size_t grain, R identity, Map map, Join join, OPT T* callerData = nullptr) {
+            // One partial per worker plus one for the caller
+            size_t callerSlot = (size_t)pool.getNumWorkers();
+            std::vector<impl::PaddedPartial<R> > partials(callerSlot + 1, impl::PaddedPartial<R>(identity));
+
+            auto body = [&] (size_t start, size_t stop, T* data, size_t slot) {
+                partials[slot].value = join(partials[slot].value, map(start, stop, data));
+            };
+            impl::runParallel(pool, begin, end, grain, body, callerData, callerSlot);
+
+            R result = identity;
+            for (auto& partial : partials) result = join(result, partial.value);
+            return result;
+        }
+    }
+}
+namespace vcore = vorb::core;
+
+#endif // !Vorb_ParallelFor_hpp__
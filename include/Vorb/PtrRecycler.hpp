@@ -19,11 +19,20 @@
 //! @endcond
 
 #ifndef VORB_USING_PCH
+#include <algorithm>
+#include <cstdlib>
+#include <new>
 #include <vector>
 
 #include "types.h"
 #endif // !VORB_USING_PCH
 
+#include "BitUtils.h"
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
 /*! @brief Creates and caches larges numbers of pointers.
  * 
  * Objects are created as unique pointers and one at a time. The
@@ -150,6 +159,237 @@ private:
     std::vector<T*> m_recycled; ///< Stack of recycled objects
 };
 
+/*! @brief Creates and caches objects in large contiguous pages.
+ *
+ * Same interface as PtrRecycler, but objects live in pages of PageSize bytes aligned to
+ * their size, so an object's page is found by masking its address. Free slots are tracked
+ * in a bitmap per page and create() always hands out the lowest free address, which keeps
+ * live objects packed for iteration and needs one allocator call per page. The free bit
+ * doubles as the recycle check, so there is no per-object overhead.
+ *
+ * @tparam T: Data type pointers
+ * @tparam PageSize: Bytes per page, must be a power of two
+ */
+template<typename T, size_t PageSize = 65536>
+class SlabPtrRecycler {
+    /*! @brief Page header, followed by the object slots.
+     */
+    struct Page {
+    public:
+        size_t freeCount; ///< Number of free slots
+        ui64 freeBits[(PageSize / sizeof(T) + 63) / 64]; ///< Set bits mark free slots
+    };
+public:
+    static const size_t HEADER_SIZE = ((sizeof(Page) + 63) / 64) * 64; ///< Header rounded to a cache line
+    static const size_t OBJECTS_PER_PAGE = (PageSize - HEADER_SIZE) / sizeof(T); ///< Slots per page
+
+    /*! @brief Default constructor.
+     */
+    SlabPtrRecycler() {
+        static_assert((PageSize & (PageSize - 1)) == 0, "PageSize must be a power of two");
+        static_assert(OBJECTS_PER_PAGE > 0, "PageSize is too small to hold an object");
+    }
+    /*! @brief Frees all constructed objects.
+     *
+     * The destructor calls freeAll().
+     */
+    ~SlabPtrRecycler() {
+        freeAll();
+    }
+
+    /*! @brief Obtain a new object.
+     *
+     * Objects created using this method should be recycled in
+     * order to preserve memory.
+     *
+     * @tparam Args: Types of constructor arguments.
+     * @param args: Argument values for object constructor.
+     * @return A pointer to an object.
+     */
+    template<typename... Args>
+    CALLEE_DELETE T* create(Args... args) {
+        // Lowest page with room
+        size_t p = m_firstFreePage;
+        while (p < m_pages.size() && m_pages[p]->freeCount == 0) p++;
+        if (p == m_pages.size()) p = addPage();
+        m_firstFreePage = p;
+
+        // Lowest free slot
+        Page* page = m_pages[p];
+        if (page->freeCount == OBJECTS_PER_PAGE) m_emptyPages--;
+        size_t w = 0;
+        while (page->freeBits[w] == 0) w++;
+        size_t slot = (w << 6) + vorb::lowestSetBit(page->freeBits[w]);
+        page->freeBits[w] &= page->freeBits[w] - 1;
+        page->freeCount--;
+        m_liveCount++;
+
+        // Call the constructor
+        T* data = getSlots(page) + slot;
+        new (data)T(args...);
+        return data;
+    }
+
+    /*! @brief Recycle the memory for later use.
+     *
+     * The object's destructor will be called, and it
+     * should not be used after this point.
+     *
+     * @pre: The object pointer must have been constructed from this pool
+     *
+     * @param data: Object to be destroyed
+     */
+    void recycle(T* data) {
+        Page* page = (Page*)((uintptr_t)data & ~(uintptr_t)(PageSize - 1));
+        size_t slot = data - getSlots(page);
+
+        // Make sure it hasn't already been recycled
+        ui64 bit = 1ull << (slot & 63);
+        if (page->freeBits[slot >> 6] & bit) return;
+        page->freeBits[slot >> 6] |= bit;
+        page->freeCount++;
+        m_liveCount--;
+
+        // Call the destructor
+        data->~T();
+
+        size_t p = findPage(page);
+        if (p < m_firstFreePage) m_firstFreePage = p;
+
+        // Apply the shrink policy to fully empty pages
+        if (page->freeCount == OBJECTS_PER_PAGE) {
+            m_emptyPages++;
+            if (m_emptyPages > m_maxEmptyPages) releasePage(p);
+        }
+    }
+
+    /*! @brief Releases every page that holds no live objects.
+     */
+    void shrink() {
+        for (size_t p = m_pages.size(); p > 0;) {
+            p--;
+            if (m_pages[p]->freeCount == OBJECTS_PER_PAGE) releasePage(p);
+        }
+    }
+
+    /*! @brief Free all allocated objects.
+     */
+    void freeAll() {
+        for (auto& page : m_pages) {
+            // Call the destructor if necessary
+            if (page->freeCount != OBJECTS_PER_PAGE) {
+                T* slots = getSlots(page);
+                for (size_t i = 0; i < OBJECTS_PER_PAGE; i++) {
+                    if ((page->freeBits[i >> 6] & (1ull << (i & 63))) == 0) slots[i].~T();
+                }
+            }
+            freePage(page);
+        }
+
+        // Empty out the lists
+        std::vector<Page*>().swap(m_pages);
+        m_firstFreePage = 0;
+        m_emptyPages = 0;
+        m_liveCount = 0;
+    }
+
+    /*! @brief Sets how many fully empty pages are kept around for reuse.
+     *
+     * Pages that become empty beyond this count are released immediately. Use 0 to
+     * release eagerly, or a large value to only release in shrink() and freeAll().
+     *
+     * @param maxEmptyPages: Number of empty pages to retain
+     */
+    void setMaxEmptyPages(size_t maxEmptyPages) {
+        m_maxEmptyPages = maxEmptyPages;
+        while (m_emptyPages > m_maxEmptyPages) {
+            size_t p = m_pages.size();
+            while (m_pages[--p]->freeCount != OBJECTS_PER_PAGE) continue;
+            releasePage(p);
+        }
+    }
+
+    /// Getters
+    size_t getPageCount() const { return m_pages.size(); }
+    const size_t& getLiveCount() const { return m_liveCount; }
+    const size_t& getEmptyPageCount() const { return m_emptyPages; }
+private:
+    // The recycler may not be copied to avoid ownership issues
+    VORB_NON_COPYABLE(SlabPtrRecycler);
+
+    /*! @param page: Page header
+     * @return First object slot of the page
+     */
+    static T* getSlots(Page* page) {
+        return (T*)((ui8*)page + HEADER_SIZE);
+    }
+    /*! @brief Allocates a page aligned to its size and inserts it in address order.
+     *
+     * @return Index of the new page
+     */
+    size_t addPage() {
+        Page* page;
+#if defined(_MSC_VER)
+        page = (Page*)_aligned_malloc(PageSize, PageSize);
+#else
+        void* mem = nullptr;
+        if (posix_memalign(&mem, PageSize, PageSize) != 0) mem = nullptr;
+        page = (Page*)mem;
+#endif
+        if (!page) throw std::bad_alloc();
+
+        // Mark every slot free
+        page->freeCount = OBJECTS_PER_PAGE;
+        const size_t numWords = sizeof(page->freeBits) / sizeof(ui64);
+        for (size_t w = 0; w < numWords; w++) {
+            size_t first = w << 6;
+            if (first + 64 <= OBJECTS_PER_PAGE) {
+                page->freeBits[w] = ~0ull;
+            } else if (first < OBJECTS_PER_PAGE) {
+                page->freeBits[w] = (1ull << (OBJECTS_PER_PAGE - first)) - 1;
+            } else {
+                page->freeBits[w] = 0;
+            }
+        }
+        m_emptyPages++;
+
+        size_t p = findPage(page);
+        m_pages.insert(m_pages.begin() + p, page);
+        return p;
+    }
+    /*! @param page: Page header
+     * @return Index of the page in m_pages
+     */
+    size_t findPage(Page* page) const {
+        return std::lower_bound(m_pages.begin(), m_pages.end(), page) - m_pages.begin();
+    }
+    /*! @brief Frees an empty page.
+     *
+     * @param p: Index of the page
+     */
+    void releasePage(size_t p) {
+        freePage(m_pages[p]);
+        m_pages.erase(m_pages.begin() + p);
+        m_emptyPages--;
+        if (m_firstFreePage > p) m_firstFreePage--;
+    }
+    /*! @param page: Page memory to return to the system
+     */
+    static void freePage(Page* page) {
+#if defined(_MSC_VER)
+        _aligned_free(page);
+#else
+        free(page);
+#endif
+    }
+
+    std::vector<Page*> m_pages; ///< All pages sorted by address
+    size_t m_firstFreePage = 0; ///< No page below this index has free slots
+    size_t m_emptyPages = 0; ///< Pages without live objects
+    size_t m_maxEmptyPages = 1; ///< Empty pages retained before releasing
+    size_t m_liveCount = 0; ///< Number of constructed objects
+};
+
 #endif // !Vorb_PtrRecycler_hpp__
 
 /*! \example "Free-lists in Vorb"
@@ -0,0 +1,196 @@
+//
+// TaskRecycler.hpp
+// Vorb Engine
+//
+// Created by agent on 17 Oct 2026
+// Copyright 2014 Regrowth Studios
+// All Rights Reserved
+//
+
+/*! \file TaskRecycler.hpp
+ * @brief Thread-safe free-list for ThreadPool tasks.
+ */
+
+#pragma once
+
+#ifndef Vorb_TaskRecycler_hpp__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_TaskRecycler_hpp__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "types.h"
+#endif // !VORB_USING_PCH
+
+#include "ThreadPool.h"
+
+namespace vorb {
+    namespace core {
+        /*! @brief Creates and caches task objects for a ThreadPool.
+         *
+         * Works like PtrRecycler, but tasks may be recycled from any thread. Each worker
+         * collects finished tasks in its own cache and hands them to a lock-free depot
+         * in batches, where create() picks them up again. Once the caches are warm, submitting
+         * a task does not touch the allocator.
+         *
+         * Tasks created here are recycled automatically by the worker that runs them, unless
+         * they should be added to the finished tasks queue, in which case the receiver must
+         * call recycle() itself.
+         *
+         * @tparam T: Worker data type of the ThreadPool
+         * @tparam Task: Concrete task type, derived from IThreadPoolTask<T>
+         */
+        template<typename T, typename Task>
+        class TaskRecycler : public ITaskRecycler<T> {
+        public:
+            /*! @brief Sets up one cache per worker of the pool.
+             *
+             * @param threadPool: Initialized pool that will execute the tasks
+             * @param batchSize: Number of tasks a worker gathers before publishing them
+             */
+            TaskRecycler(const ThreadPool<T>& threadPool, size_t batchSize = 64) :
+                m_caches(threadPool.getNumWorkers()),
+                m_batchSize(batchSize) {
+                for (auto& cache : m_caches) cache.tasks.reserve(batchSize);
+            }
+            /*! @brief Frees all constructed tasks.
+             *
+             * The destructor calls freeAll().
+             */
+            virtual ~TaskRecycler() {
+                freeAll();
+            }
+
+            /*! @brief Obtain a new task.
+             *
+             * @tparam Args: Types of constructor arguments.
+             * @param args: Argument values for task constructor.
+             * @return A pointer to a task.
+             */
+            template<typename... Args>
+            CALLEE_DELETE Task* create(Args... args) {
+                TaskBind* bind;
+                if (m_depot.try_dequeue(bind)) {
+                    m_stats.hits++;
+                } else {
+                    // Create a new data segment
+                    bind = (TaskBind*)operator new(sizeof(TaskBind));
+                    new (&bind->recycleCheck) std::atomic<i32>();
+
+                    std::lock_guard<std::mutex> lock(m_allocationLock);
+                    m_allocated.push_back(bind);
+                    m_stats.misses++;
+                }
+                bind->recycleCheck.store(0, std::memory_order_relaxed);
+
+                // Call the constructor
+                Task* task = new (&bind->data) Task(args...);
+                task->setRecycler(this);
+                return task;
+            }
+
+            /*! @brief Recycle the memory for later use.
+             *
+             * The task's destructor will be called, and it should not be used after this point.
+             *
+             * @pre: The task must have been created by this recycler
+             *
+             * @param task: Task to be destroyed
+             * @param workerIndex: Index of the recycling worker, or -1 if not called from a worker
+             */
+            virtual void recycle(IThreadPoolTask<T>* task, i32 workerIndex = -1) override {
+                TaskBind* bind = (TaskBind*)static_cast<Task*>(task);
+
+                // Make sure it hasn't already been recycled
+                if (bind->recycleCheck.exchange(1, std::memory_order_acq_rel) != 0) return;
+                bind->data.~Task();
+
+                if (workerIndex >= 0 && (size_t)workerIndex < m_caches.size()) {
+                    // Only this worker touches its cache
+                    std::vector<TaskBind*>& cache = m_caches[workerIndex].tasks;
+                    cache.push_back(bind);
+                    if (cache.size() >= m_batchSize) {
+                        m_depot.enqueue_bulk(cache.data(), cache.size());
+                        cache.clear();
+                    }
+                } else {
+                    m_depot.enqueue(bind);
+                }
+            }
+
+            /*! @brief Free all allocated tasks.
+             *
+             * @pre: No task from this recycler may be queued or executing
+             */
+            void freeAll() {
+                std::lock_guard<std::mutex> lock(m_allocationLock);
+                if (m_allocated.size() > 0) {
+                    // Free all allocated memory
+                    for (size_t i = m_allocated.size(); i > 0;) {
+                        i--;
+
+                        // Call the destructor if necessary
+                        if (m_allocated[i]->recycleCheck.load(std::memory_order_relaxed) == 0) {
+                            m_allocated[i]->data.~Task();
+                        }
+
+                        // Free the data
+                        operator delete(m_allocated[i]);
+                    }
+
+                    // Empty out the lists
+                    std::vector<TaskBind*>().swap(m_allocated);
+                    TaskBind* bind;
+                    while (m_depot.try_dequeue(bind)) continue;
+                    for (auto& cache : m_caches) cache.tasks.clear();
+                }
+            }
+
+            /// Getters
+            size_t getAllocatedCount() const { return m_allocated.size(); }
+            ui64 getHitCount() const { return m_stats.hits.load(); }
+            ui64 getMissCount() const { return m_stats.misses.load(); }
+        private:
+            // The recycler may not be copied to avoid ownership issues
+            VORB_NON_COPYABLE(TaskRecycler);
+
+            /*! @brief Value tracking struct to limit destructor calls.
+             */
+            struct TaskBind {
+            public:
+                Task data; ///< Task value
+                std::atomic<i32> recycleCheck; ///< Counter that tracks recycling calls
+            };
+
+            /*! @brief Per-worker batch, padded so neighbouring workers do not share a cache line.
+             */
+            struct WorkerCache {
+            public:
+                std::vector<TaskBind*> tasks; ///< Recycled tasks not yet published
+                ui8 padding[64]; ///< Keeps the next cache's header off this line
+            };
+
+            /*! @brief Creation counters.
+             */
+            struct Stats {
+            public:
+                std::atomic<ui64> hits = ATOMIC_VAR_INIT(0); ///< Tasks served from the depot
+                std::atomic<ui64> misses = ATOMIC_VAR_INIT(0); ///< Tasks that required an allocation
+            };
+
+            std::vector<WorkerCache> m_caches; ///< One cache per worker
+            size_t m_batchSize; ///< Tasks per published batch
+            moodycamel::ConcurrentQueue<TaskBind*> m_depot; ///< Recycled tasks ready for create()
+            std::vector<TaskBind*> m_allocated; ///< All the allocated task blocks
+            std::mutex m_allocationLock; ///< Guards m_allocated, only taken on allocation
+            Stats m_stats; ///< Hit/miss counters
+        };
+    }
+}
+namespace vcore = vorb::core;
+
+#endif // !Vorb_TaskRecycler_hpp__
@@ -16,13 +16,16 @@
 #ifndef ThreadPool_h__
 #define ThreadPool_h__
 
+#include <atomic>
 #include <vector>
+#include <queue>
 #include <thread>
 #include <condition_variable>
 
 #include "concurrentqueue.h"
 #include "blockingconcurrentqueue.h"
 #include "IThreadPoolTask.h"
+#include "ScopedTiming.hpp"
 
 class CAEngine;
 class Chunk;
@@ -35,15 +38,32 @@ enum class RenderTaskType;
 
 namespace vorb {
     namespace core {
+        /// Strategy used by a ThreadPool to hand tasks to its workers
+        enum class ThreadPoolScheduler {
+            SHARED_QUEUE, ///< All workers dequeue from a single shared queue
+            WORK_STEALING ///< Each worker owns a queue and steals from random peers when it runs dry
+        };
+
+        /// Counters for a single priority lane of a ThreadPool
+        struct ThreadPoolLaneStats {
+        public:
+            std::atomic<i64> depth = ATOMIC_VAR_INIT(0); ///< Tasks currently waiting in the lane
+            std::atomic<ui64> deadlineMisses = ATOMIC_VAR_INIT(0); ///< Tasks that started after their deadline
+            MTDetailedSamplerContext latency; ///< Time between submission and execution start
+        };
+
         template<typename T>
         class ThreadPool {
         public:
+            typedef typename IThreadPoolTask<T>::Clock Clock;
+
             ThreadPool() {};
             ~ThreadPool();
 
             /// Initializes the threadpool
             /// @param size: The number of worker threads
-            void init(ui32 size);
+            /// @param scheduler: How tasks are distributed amongst the workers
+            void init(ui32 size, ThreadPoolScheduler scheduler = ThreadPoolScheduler::SHARED_QUEUE);
 
             /// Frees all resources
             void destroy();
@@ -53,16 +73,12 @@ namespace vorb {
 
             /// Adds a task to the task queue
             /// @param task: The task to add
-            void addTask(IThreadPoolTask<T>* task) {
-                m_tasks.enqueue(task);
-            }
+            void addTask(IThreadPoolTask<T>* task);
 
             /// Add an array of tasks to the task queue
             /// @param tasks: The array of tasks to add
             /// @param size: The size of the array
-            void addTasks(IThreadPoolTask<T>* tasks[], size_t size) {
-                m_tasks.enqueue_bulk(tasks, size);
-            }
+            void addTasks(IThreadPoolTask<T>* tasks[], size_t size);
 
             /// Gets a bulk of tasks from the finished tasks
             /// @param taskBuffer: Buffer to store the tasks
@@ -72,22 +88,51 @@ namespace vorb {
                 return m_finishedTasks.try_dequeue_bulk(taskBuffer, maxSize);
             }
 
+            /// Sets how many times a waiting lane may be passed over by higher lanes
+            /// before it is served first
+            /// @param threshold: Number of skips before a lane is promoted
+            void setAgingThreshold(ui32 threshold) { m_agingThreshold = threshold; }
+            /// Sets how close to its deadline a task must be before it preempts the priority lanes
+            /// @param us: Horizon in microseconds
+            void setDeadlineHorizon(UNIT_SPACE(MICROSECONDS) ui64 us) {
+                m_deadlineHorizon = std::chrono::duration_cast<typename Clock::duration>(std::chrono::microseconds(us));
+            }
+
             /// Getters
             i32 getNumWorkers() const { return m_workers.size(); }
-            size_t getTasksSizeApprox() const { return m_tasks.size_approx(); }
+            size_t getTasksSizeApprox() const { return (size_t)m_taskPermits.availableApprox(); }
             size_t getFinishedTasksSizeApprox() const { return m_finishedTasks.size_approx(); }
+            const ThreadPoolScheduler& getScheduler() const { return m_scheduler; }
+            const ThreadPoolLaneStats& getLaneStats(TaskPriority lane) const { return m_laneStats[(size_t)lane]; }
         private:
             VORB_NON_COPYABLE(ThreadPool);
             // Typedef for func ptr
-            typedef void (ThreadPool<T>::*workerFunc)(T*);
+            typedef void (ThreadPool<T>::*workerFunc)(T*, ui32);
+            typedef moodycamel::ConcurrentQueue<IThreadPoolTask<T>*> TaskQueue;
+
+            /// One lock free queue per priority lane
+            struct LaneQueues {
+            public:
+                TaskQueue lanes[NUM_TASK_PRIORITIES];
+            };
+
+            /// Task waiting on the deadline heap
+            struct DeadlineEntry {
+            public:
+                typename Clock::time_point deadline;
+                IThreadPoolTask<T>* task;
+                /// Reversed so std::priority_queue yields the earliest deadline
+                bool operator<(const DeadlineEntry& o) const { return deadline > o.deadline; }
+            };
 
             /// Class definition for worker thread
             class WorkerThread {
             public:
                 /// Creates the thread
                 /// @param func: The function the thread should execute
-                WorkerThread(workerFunc func, ThreadPool<T>* threadPool) {
-                    thread = new std::thread(func, threadPool, &data);
+                /// @param index: Index of this worker within the pool
+                WorkerThread(workerFunc func, ThreadPool<T>* threadPool, ui32 index) {
+                    thread = new std::thread(func, threadPool, &data, index);
                 }
 
                 /// Blocks until the worker thread completes
@@ -97,18 +142,69 @@ namespace vorb {
 
                 std::thread* thread; ///< The thread handle
                 T data; ///< Worker specific data
+                LaneQueues localTasks; ///< Tasks owned by this worker (WORK_STEALING only)
             };
 
             /// Thread function that processes tasks
             /// @param data: The worker specific data
-            void workerThreadFunc(T* data);
+            /// @param index: Index of the worker's local queues
+            void workerThreadFunc(T* data, ui32 index);
+
+            /// Runs a task, enqueues continuations that became ready and stores it as finished
+            /// if requested, otherwise hands it to its recycler
+            /// @param task: The task to execute
+            /// @param data: The worker specific data
+            /// @param index: Index of the executing worker, whose queues receive the continuations
+            /// @param ready: Scratch list for released continuations
+            void runTask(IThreadPoolTask<T>* task, T* data, ui32 index, std::vector<IThreadPoolTask<T>*>& ready);
+
+            /// Stamps tasks and pushes them into lanes or the deadline heap.
+            /// The caller is responsible for signaling permits.
+            /// @param tasks: The array of tasks to add
+            /// @param size: The size of the array
+            /// @param queues: Destination lanes
+            void enqueueTasks(IThreadPoolTask<T>* tasks[], size_t size, LaneQueues& queues);
+
+            /// Dequeues the most urgent task. The caller must own a permit from m_taskPermits,
+            /// which guarantees a task exists.
+            /// @param index: Local queues that should be tried first
+            /// @param seed: Per-thread random state used to pick victims
+            /// @return The dequeued task
+            IThreadPoolTask<T>* dequeueTask(ui32 index, ui32& seed);
+            /// Tries to take a task from one lane
+            /// @return True if a task was dequeued
+            bool tryDequeueLane(size_t lane, ui32 index, ui32& seed, OUT IThreadPoolTask<T>*& task);
+            /// Tries to take the earliest deadline task
+            /// @param force: Ignore the deadline horizon
+            /// @return True if a task was dequeued
+            bool tryDequeueDeadline(bool force, OUT IThreadPoolTask<T>*& task);
+            /// Updates lane counters for a task about to execute
+            /// @param task: The dequeued task
+            void recordDequeue(IThreadPoolTask<T>* task);
 
             /// Lock free task queues
-            moodycamel::BlockingConcurrentQueue<IThreadPoolTask<T>*> m_tasks; ///< Holds tasks to execute
+            LaneQueues m_tasks; ///< Holds tasks to execute (SHARED_QUEUE only)
             moodycamel::ConcurrentQueue<IThreadPoolTask<T>*> m_finishedTasks; ///< Holds finished tasks
 
+            /// One permit per task waiting anywhere in the pool
+            moodycamel::details::mpmc_sema::LightweightSemaphore m_taskPermits;
+            std::atomic<ui32> m_nextQueue = ATOMIC_VAR_INIT(0); ///< Round-robin target for submitted tasks
+
+            /// Earliest-deadline-first heap for tasks with deadlines
+            std::priority_queue<DeadlineEntry> m_deadlineTasks;
+            std::mutex m_deadlineLock; ///< Guards m_deadlineTasks
+            std::atomic<typename Clock::rep> m_nextDeadline = ATOMIC_VAR_INIT(NO_DEADLINE); ///< Cached top of the heap
+            typename Clock::duration m_deadlineHorizon = std::chrono::milliseconds(2); ///< How early deadline tasks preempt lanes
+
+            ThreadPoolLaneStats m_laneStats[NUM_TASK_PRIORITIES]; ///< Per-lane counters
+            std::atomic<ui32> m_laneSkips[NUM_TASK_PRIORITIES]; ///< Times a waiting lane was passed over
+            ui32 m_agingThreshold = 16; ///< Skips before a lane is served first
+
+            ThreadPoolScheduler m_scheduler = ThreadPoolScheduler::SHARED_QUEUE; ///< Active scheduling mode
             bool m_isInitialized = false; ///< true when the pool has been initialized
             std::vector<WorkerThread*> m_workers; ///< All the worker threads
+
+            static const typename Clock::rep NO_DEADLINE = INT64_MAX; ///< m_nextDeadline when the heap is empty
         };
 
         template<typename T>
@@ -123,4 +219,10 @@ namespace vcore = vorb::core;
 
 #include "ThreadPool.inl"
 
-#endif // ThreadPool_h__
\ No newline at end of file
+#endif // ThreadPool_h__
+
+/*! \example "ThreadPool Scheduler Benchmark"
+ *
+ * Compares the shared queue and work-stealing schedulers on a chunk-sized task mix.
+ * \include VorbThreadPoolBench.cpp
+ */
\ No newline at end of file
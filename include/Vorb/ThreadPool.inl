@@ -6,19 +6,27 @@ vcore::ThreadPool<T>::~ThreadPool() {
 template<typename T>
 void vcore::ThreadPool<T>::clearTasks() {
     // TODO(Ben): I hope this doesn't cause a crash when threads are dequeuing
-    moodycamel::BlockingConcurrentQueue<IThreadPoolTask<T>*>().swap(m_tasks);
+    // Tasks may only be removed by permit holders, so workers never wait on a missing task
+    ui32 seed = 0x9E3779B9u;
+    while (m_taskPermits.tryWait()) {
+        // Pooled tasks will never run, give them back to their owner
+        IThreadPoolTask<T>* task = dequeueTask(0, seed);
+        if (task->getRecycler()) task->getRecycler()->recycle(task);
+    }
 }
 
 template<typename T>
-void vcore::ThreadPool<T>::init(ui32 size) {
+void vcore::ThreadPool<T>::init(ui32 size, ThreadPoolScheduler scheduler /*= ThreadPoolScheduler::SHARED_QUEUE*/) {
     // Check if its already initialized
     if (m_isInitialized) return;
     m_isInitialized = true;
+    m_scheduler = scheduler;
+    for (size_t i = 0; i < NUM_TASK_PRIORITIES; i++) m_laneSkips[i].store(0);
 
     /// Allocate all threads
     m_workers.resize(size);
     for (ui32 i = 0; i < size; i++) {
-        m_workers[i] = new WorkerThread(&ThreadPool::workerThreadFunc, this);
+        m_workers[i] = new WorkerThread(&ThreadPool::workerThreadFunc, this, i);
     }
 }
 
@@ -30,40 +38,213 @@ void vcore::ThreadPool<T>::destroy() {
     std::vector<QuitThreadPoolTask<T> > quitTasks(m_workers.size());
     for (size_t i = 0; i < m_workers.size(); i++) {
         m_workers[i]->data.stop = true;
-        m_tasks.enqueue(&quitTasks[i]);
+        quitTasks[i].setPriority(TaskPriority::HIGH);
+        addTask(&quitTasks[i]);
     }
-    
+
     // Join all threads
     for (size_t i = 0; i < m_workers.size(); i++) {
         m_workers[i]->join();
-        delete m_workers[i];
     }
 
+    // Clear all tasks (local queues live in the workers)
+    clearTasks();
+
     // Free memory
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        delete m_workers[i];
+    }
     std::vector<WorkerThread*>().swap(m_workers);
 
-    // Clear all tasks
-    clearTasks();
-
     // We are no longer initialized
     m_isInitialized = false;
 }
 
 template<typename T>
-void vcore::ThreadPool<T>::workerThreadFunc(T* data) {
+void vcore::ThreadPool<T>::addTask(IThreadPoolTask<T>* task) {
+    if (m_scheduler == ThreadPoolScheduler::WORK_STEALING) {
+        ui32 q = m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+        enqueueTasks(&task, 1, m_workers[q]->localTasks);
+    } else {
+        enqueueTasks(&task, 1, m_tasks);
+    }
+    m_taskPermits.signal();
+}
+
+template<typename T>
+void vcore::ThreadPool<T>::addTasks(IThreadPoolTask<T>* tasks[], size_t size) {
+    if (size == 0) return;
+    if (m_scheduler == ThreadPoolScheduler::WORK_STEALING) {
+        // Spread the batch in contiguous slices so each worker starts with local work
+        size_t numWorkers = m_workers.size();
+        size_t slice = (size + numWorkers - 1) / numWorkers;
+        ui32 q = m_nextQueue.fetch_add((ui32)numWorkers, std::memory_order_relaxed);
+        for (size_t i = 0; i < size; i += slice) {
+            size_t count = (i + slice > size) ? size - i : slice;
+            enqueueTasks(tasks + i, count, m_workers[q++ % numWorkers]->localTasks);
+        }
+    } else {
+        enqueueTasks(tasks, size, m_tasks);
+    }
+    m_taskPermits.signal((moodycamel::details::mpmc_sema::LightweightSemaphore::ssize_t)size);
+}
+
+template<typename T>
+void vcore::ThreadPool<T>::enqueueTasks(IThreadPoolTask<T>* tasks[], size_t size, LaneQueues& queues) {
+    // Stamp everything before it becomes visible to workers
+    typename Clock::time_point now = Clock::now();
+    for (size_t i = 0; i < size; i++) {
+        tasks[i]->setSubmitTime(now);
+        m_laneStats[(size_t)tasks[i]->getPriority()].depth++;
+    }
+
+    // Push runs of tasks sharing a lane in bulk
+    size_t runStart = 0;
+    for (size_t i = 0; i <= size; i++) {
+        if (i < size && !tasks[i]->hasDeadline() && tasks[i]->getPriority() == tasks[runStart]->getPriority()) continue;
+
+        if (i > runStart) {
+            queues.lanes[(size_t)tasks[runStart]->getPriority()].enqueue_bulk(tasks + runStart, i - runStart);
+        }
+        runStart = i;
+        if (i < size && tasks[i]->hasDeadline()) {
+            std::lock_guard<std::mutex> lock(m_deadlineLock);
+            DeadlineEntry entry = { tasks[i]->getDeadline(), tasks[i] };
+            m_deadlineTasks.push(entry);
+            m_nextDeadline.store(m_deadlineTasks.top().deadline.time_since_epoch().count());
+            runStart = i + 1;
+        }
+    }
+}
+
+template<typename T>
+void vcore::ThreadPool<T>::workerThreadFunc(T* data, ui32 index) {
     data->stop = false;
-    IThreadPoolTask<T>* task;
+    ui32 seed = (index + 1) * 0x9E3779B9u;
+    std::vector<IThreadPoolTask<T>*> ready;
 
     while (true) {
         // Check for exit
         if (data->stop) return;
 
-        m_tasks.wait_dequeue(task);
-        task->execute(data);
-        task->setIsFinished(true);
-        // Store result if needed
-        if (task->shouldAddToFinishedTasks()) {
-            m_finishedTasks.enqueue(task);
+        // Every permit is backed by exactly one queued task
+        m_taskPermits.wait();
+        runTask(dequeueTask(index, seed), data, index, ready);
+    }
+}
+
+template<typename T>
+inline void vcore::ThreadPool<T>::runTask(IThreadPoolTask<T>* task, T* data, ui32 index, std::vector<IThreadPoolTask<T>*>& ready) {
+    task->execute(data);
+
+    // Successors go straight to this worker's queues, no main thread round trip.
+    // This must happen before the task is marked finished, since it may be deleted afterwards.
+    if (task->hasContinuations()) {
+        task->releaseContinuations(ready);
+        if (ready.size() > 0) {
+            LaneQueues& queues = (m_scheduler == ThreadPoolScheduler::WORK_STEALING) ? m_workers[index]->localTasks : m_tasks;
+            enqueueTasks(ready.data(), ready.size(), queues);
+            m_taskPermits.signal((moodycamel::details::mpmc_sema::LightweightSemaphore::ssize_t)ready.size());
+            ready.clear();
+        }
+    }
+
+    task->setIsFinished(true);
+    // Store result if needed
+    if (task->shouldAddToFinishedTasks()) {
+        m_finishedTasks.enqueue(task);
+    } else if (task->getRecycler()) {
+        task->getRecycler()->recycle(task, (i32)index);
+    }
+}
+
+template<typename T>
+vcore::IThreadPoolTask<T>* vcore::ThreadPool<T>::dequeueTask(ui32 index, ui32& seed) {
+    IThreadPoolTask<T>* task;
+    while (true) {
+        // Deadlines that are about to expire preempt the lanes
+        if (tryDequeueDeadline(false, task)) break;
+
+        // Lanes that have been passed over too often are served before their betters
+        bool found = false;
+        for (size_t lane = 0; lane < NUM_TASK_PRIORITIES - 1 && !found; lane++) {
+            if (m_laneSkips[lane].load(std::memory_order_relaxed) >= m_agingThreshold) {
+                m_laneSkips[lane].store(0, std::memory_order_relaxed);
+                found = tryDequeueLane(lane, index, seed, task);
+            }
+        }
+        // Highest priority first
+        for (size_t lane = NUM_TASK_PRIORITIES; lane > 0 && !found;) {
+            lane--;
+            found = tryDequeueLane(lane, index, seed, task);
+        }
+        if (found) break;
+
+        // Lanes are dry, so deadline tasks may run early
+        if (tryDequeueDeadline(true, task)) break;
+
+        // The task we hold a permit for is still in flight on another core
+        std::this_thread::yield();
+    }
+    recordDequeue(task);
+    return task;
+}
+
+template<typename T>
+bool vcore::ThreadPool<T>::tryDequeueLane(size_t lane, ui32 index, ui32& seed, OUT IThreadPoolTask<T>*& task) {
+    bool found = false;
+    if (m_scheduler == ThreadPoolScheduler::WORK_STEALING) {
+        ui32 numWorkers = (ui32)m_workers.size();
+
+        // Local work first, then sweep all peers starting from a random victim
+        found = m_workers[index]->localTasks.lanes[lane].try_dequeue(task);
+        if (!found) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            ui32 victim = seed % numWorkers;
+            for (ui32 i = 0; i < numWorkers && !found; i++) {
+                found = m_workers[victim]->localTasks.lanes[lane].try_dequeue(task);
+                if (++victim == numWorkers) victim = 0;
+            }
         }
+    } else {
+        found = m_tasks.lanes[lane].try_dequeue(task);
     }
+    if (!found) return false;
+
+    // Age the lanes we passed over
+    for (size_t l = 0; l < lane; l++) {
+        if (m_laneStats[l].depth.load(std::memory_order_relaxed) > 0) {
+            m_laneSkips[l].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return true;
+}
+
+template<typename T>
+bool vcore::ThreadPool<T>::tryDequeueDeadline(bool force, OUT IThreadPoolTask<T>*& task) {
+    typename Clock::rep next = m_nextDeadline.load(std::memory_order_relaxed);
+    if (next == NO_DEADLINE) return false;
+
+    typename Clock::rep horizon = (Clock::now() + m_deadlineHorizon).time_since_epoch().count();
+    if (!force && next > horizon) return false;
+
+    std::lock_guard<std::mutex> lock(m_deadlineLock);
+    if (m_deadlineTasks.empty()) return false;
+    if (!force && m_deadlineTasks.top().deadline.time_since_epoch().count() > horizon) return false;
+
+    task = m_deadlineTasks.top().task;
+    m_deadlineTasks.pop();
+    m_nextDeadline.store(m_deadlineTasks.empty() ? NO_DEADLINE : m_deadlineTasks.top().deadline.time_since_epoch().count());
+    return true;
+}
+
+template<typename T>
+inline void vcore::ThreadPool<T>::recordDequeue(IThreadPoolTask<T>* task) {
+    typename Clock::time_point now = Clock::now();
+    ThreadPoolLaneStats& stats = m_laneStats[(size_t)task->getPriority()];
+    stats.depth--;
+    stats.latency += std::chrono::duration_cast<std::chrono::microseconds>(now - task->getSubmitTime()).count();
+    if (task->hasDeadline() && now > task->getDeadline()) stats.deadlineMisses++;
 }
@@ -15,6 +15,8 @@
 #ifndef BitTable_hpp__
 #define BitTable_hpp__
 
+#include <cstring>
+
 namespace vorb {
     namespace ecs {
         class BitTable;
@@ -170,6 +172,35 @@ namespace vorb {
             void addRow() {
                 // Add a bunch of columns
                 for (ui32 i = 0; i < m_columns; i++) m_bits.emplace_back();
+                m_rows++;
+            }
+            /// Add several cleared rows to the table with a single allocation
+            /// @param n: Number of rows to add
+            void addRows(const ui32& n) {
+                m_rows += n;
+                m_bits.resize(m_rows * m_columns, 0);
+            }
+
+            /// Check that a row holds every bit of a mask
+            /// @param r: Row to test, rows past the end of the table hold no bits
+            /// @param mask: Bits stored in the same byte layout as a row
+            /// @param maskBytes: Number of bytes in the mask (at most the row's byte count)
+            /// @return True if (row & mask) == mask
+            bool rowContains(const ui32& r, const ui8* mask, const ui32& maskBytes) const {
+                if (r >= m_rows) return false;
+                const ui8* bits = &m_bits[r * m_columns];
+                // Rows are byte aligned, so whole words are copied out before they are compared
+                ui32 i = 0;
+                for (; i + sizeof(ui64) <= maskBytes; i += sizeof(ui64)) {
+                    ui64 m, b;
+                    memcpy(&m, mask + i, sizeof(ui64));
+                    memcpy(&b, bits + i, sizeof(ui64));
+                    if (m & ~b) return false;
+                }
+                for (; i < maskBytes; i++) {
+                    if (mask[i] & ~bits[i]) return false;
+                }
+                return true;
             }
 
         private:
@@ -0,0 +1,151 @@
+///
+/// ComponentQuery.hpp
+/// Vorb Engine
+///
+/// Created by agent on 17 Oct 2026
+/// Copyright 2014 Regrowth Studios
+/// All Rights Reserved
+///
+/// Summary:
+/// Iterates entities that hold a component in several tables
+///
+
+#pragma once
+
+#ifndef ComponentQuery_hpp__
+#define ComponentQuery_hpp__
+
+#include <tuple>
+
+#include "ComponentTable.hpp"
+#include "ECS.h"
+
+namespace vorb {
+    namespace ecs {
+        namespace impl {
+            template<size_t... Is>
+            struct index_sequence {};
+            template<size_t N, size_t... Is>
+            struct make_index_sequence : make_index_sequence<N - 1, N - 1, Is...> {};
+            template<size_t... Is>
+            struct make_index_sequence<0, Is...> : index_sequence<Is...> {};
+        }
+
+        /// Joins component tables through the component truth table of an ECS
+        ///
+        /// The join walks the packed entities of the smallest table and keeps those whose
+        /// row in the truth table holds the bit of every other table, so membership costs
+        /// one masked row read per candidate and components come from the packed arrays.
+        /// Components must not be added to or removed from the joined tables during iteration.
+        /// @tparam T: Component types of the joined tables
+        template<typename... T>
+        class ComponentQuery {
+        public:
+            /// Build a query, choosing the smallest table to drive the join
+            /// @param bits: Truth table of the ECS that owns the tables
+            /// @param tables: Component tables to join
+            ComponentQuery(const BitTable* bits, ComponentTable<T>&... tables) :
+                m_bits(bits),
+                m_tables(&tables...) {
+                TableID ids[] = { tables.getID()... };
+                size_t sizes[] = { tables.getComponentListSize()... };
+                for (size_t i = 0; i < sizeof...(T); i++) {
+                    ui32 byte = ids[i] >> 3;
+                    if (byte >= m_mask.size()) m_mask.resize(byte + 1, 0);
+                    m_mask[byte] |= 0x01 << (ids[i] & 0x07);
+                    if (sizes[i] < sizes[m_driver]) m_driver = i;
+                }
+            }
+
+            /// @return Number of candidates the join walks (components in the driving table)
+            size_t getCandidateCount() const {
+                return candidateCount(impl::make_index_sequence<sizeof...(T)>());
+            }
+
+            /// Visit every matching entity
+            /// @param f: Called as f(EntityID, T&...) for each entity
+            template<typename F>
+            void forEach(F f) const {
+                visit(0, getCandidateCount(), f, impl::make_index_sequence<sizeof...(T)>());
+            }
+            /// Visit the matching entities among a range of candidates, so that
+            /// disjoint ranges may be visited concurrently
+            /// @param first: First candidate
+            /// @param last: End of the candidate range, at most getCandidateCount()
+            /// @param f: Called as f(EntityID, T&...) for each entity
+            template<typename F>
+            void forEach(size_t first, size_t last, F f) const {
+                visit(first, last, f, impl::make_index_sequence<sizeof...(T)>());
+            }
+
+            /// @return Number of matching entities
+            size_t count() const {
+                size_t n = 0;
+                forEach([&] (EntityID, T&...) { n++; });
+                return n;
+            }
+        private:
+            template<size_t... Is>
+            size_t candidateCount(impl::index_sequence<Is...>) const {
+                size_t sizes[] = { std::get<Is>(m_tables)->getComponentListSize()... };
+                return sizes[m_driver];
+            }
+
+            template<typename F, size_t... Is>
+            void visit(size_t first, size_t last, F& f, impl::index_sequence<Is...>) const {
+                const EntityID* entities[] = { std::get<Is>(m_tables)->getEntities()... };
+                const EntityID* candidates = entities[m_driver];
+                const ui8* mask = m_mask.data();
+                ui32 maskBytes = (ui32)m_mask.size();
+                for (size_t i = first; i < last; i++) {
+                    EntityID eID = candidates[i];
+                    if (!m_bits->rowContains(eID, mask, maskBytes)) continue;
+                    f(eID, component<Is>(i, eID)...);
+                }
+            }
+            /// @param i: Candidate index, which is the component's slot in the driving table
+            /// @param eID: Candidate entity
+            /// @return Component of table I, found through its sparse index unless I drives the join
+            template<size_t I>
+            typename std::tuple_element<I, std::tuple<T...> >::type& component(size_t i, EntityID eID) const {
+                auto* table = std::get<I>(m_tables);
+                return I == m_driver ? table->getData()[i] : table->getFromEntity(eID);
+            }
+
+            const BitTable* m_bits; ///< Truth table of the ECS
+            std::tuple<ComponentTable<T>*...> m_tables; ///< Joined tables
+            std::vector<ui8> m_mask; ///< Bits of the joined tables in a truth table row
+            size_t m_driver = 0; ///< Index of the table whose entities are walked
+        };
+
+        template<typename... T>
+        inline ComponentQuery<T...> ECS::query(ComponentTable<T>&... tables) {
+            trackComponentTables();
+            return ComponentQuery<T...>(&m_entityComponents, tables...);
+        }
+
+        inline void ECS::trackComponentTables() {
+            for (auto& named : _components) {
+                TableID id = named.second;
+                if (id < m_tableBitHooks.size() && m_tableBitHooks[id]) continue;
+                ComponentTableBase* table = getComponentTable(id);
+                if (!table) continue;
+
+                while (m_entityComponents.getBitColumnCount() <= id) m_entityComponents.addColumn();
+                if (id >= m_tableBitHooks.size()) m_tableBitHooks.resize(id + 1);
+                TableBitHook* hook = new TableBitHook(&m_entityComponents, id);
+                m_tableBitHooks[id].reset(hook);
+
+                // Components added before tracking started
+                for (auto& bind : *table) hook->onAdded(nullptr, bind.second, bind.first);
+                // addComponents sets the bits of bulk additions itself
+                table->onEntityAdded += makeDelegate(*hook, &TableBitHook::onAdded);
+                table->m_numBatchedListeners++;
+                table->onEntityRemoved += makeDelegate(*hook, &TableBitHook::onRemoved);
+            }
+        }
+    }
+}
+namespace vecs = vorb::ecs;
+
+#endif // ComponentQuery_hpp__
@@ -15,22 +15,66 @@
 #ifndef ComponentTable_h__
 #define ComponentTable_h__
 
+#include <stdexcept>
+
 #include "ComponentTableBase.h"
+#include "SparseIndex.hpp"
 
 namespace vorb {
     namespace ecs {
         /// Component table that stores a specific component type
+        ///
+        /// Components are packed in a dense array with a parallel array of their owning entities.
+        /// Paged sparse indices map component and entity IDs to dense slots, and removal moves
+        /// the last component into the hole, so iteration is linear and never visits dead slots.
+        /// Pointers and references to components are invalidated by adding or removing components.
         template<typename T>
         class ComponentTable : public ComponentTableBase {
         public:
-            typedef std::pair<EntityID, T> ComponentPairing; ///< A pairing of an entity to a component
-            typedef std::vector<ComponentPairing> ComponentList; ///< List of components accessed by component IDs
+            /// Iterator over packed (entity ID, component) pairings
+            /// @tparam V: Component type, possibly const qualified
+            template<typename V>
+            class PairingIterator {
+            public:
+                /// A pairing of an entity to its component, referencing packed storage
+                struct Pairing {
+                    const EntityID& first; ///< Owner entity
+                    V& second; ///< Component data
+                };
+
+                PairingIterator(const EntityID* entity, V* data) :
+                    m_entity(entity),
+                    m_data(data) {
+                    // Empty
+                }
+
+                Pairing operator*() const {
+                    return Pairing { *m_entity, *m_data };
+                }
+                PairingIterator& operator++() {
+                    m_entity++;
+                    m_data++;
+                    return *this;
+                }
+                bool operator==(const PairingIterator& other) const {
+                    return m_data == other.m_data;
+                }
+                bool operator!=(const PairingIterator& other) const {
+                    return m_data != other.m_data;
+                }
+            private:
+                const EntityID* m_entity; ///< Current entity
+                V* m_data; ///< Current component
+            };
+            typedef typename PairingIterator<T>::Pairing ComponentPairing; ///< A pairing of an entity to a component
+            typedef PairingIterator<T> iterator; ///< Iterator over packed pairings
+            typedef PairingIterator<const T> const_iterator; ///< Const iterator over packed pairings
 
             /// Constructor that requires a blank component for reference
             /// @param defaultData: Blank component data
-            ComponentTable(T defaultData) : ComponentTableBase() {
-                // Default data goes in the first slot
-                _components.emplace_back(ID_GENERATOR_NULL_ID, defaultData);
+            ComponentTable(T defaultData) : ComponentTableBase(),
+                m_defaultData(defaultData) {
+                // Empty
             }
             /// Default constructor that uses component constructor for defaults
             ComponentTable() : ComponentTable(T()) {
@@ -39,79 +83,145 @@ namespace vorb {
         
             /// Obtain a component from this table
             /// @param cID: Component ID
-            /// @return Const component reference
+            /// @return Const component reference, or the blank component if cID is not in this table
             const T& get(const ComponentID& cID) const {
-                return _components[cID].second;
+                ui32 slot = m_componentSlots.find(cID);
+                return slot == SPARSE_INDEX_NULL_SLOT ? m_defaultData : m_data[slot];
             }
             /// Obtain a component from this table
             /// @param cID: Component ID
             /// @return Component reference
+            /// @throws std::runtime_error: When cID is not in this table
             T& get(const ComponentID& cID) {
-                return _components[cID].second;
+                ui32 slot = m_componentSlots.find(cID);
+                if (slot == SPARSE_INDEX_NULL_SLOT) throw std::runtime_error("Component is not in this table");
+                return m_data[slot];
             }
             /// Obtain an entity's component from this table
             /// @param eID: Entity ID
-            /// @return Const component reference
+            /// @return Const component reference, or the blank component if the entity has none
             const T& getFromEntity(const EntityID& eID) const {
-                return get(getComponentID(eID));
+                ui32 slot = m_entitySlots.find(eID);
+                return slot == SPARSE_INDEX_NULL_SLOT ? m_defaultData : m_data[slot];
             }
             /// Obtain an entity's component from this table
             /// @param eID: Entity ID
             /// @return Component reference
+            /// @throws std::runtime_error: When the entity has no component in this table
             T& getFromEntity(const EntityID& eID) {
-                return get(getComponentID(eID));
+                ui32 slot = m_entitySlots.find(eID);
+                if (slot == SPARSE_INDEX_NULL_SLOT) throw std::runtime_error("Entity has no component in this table");
+                return m_data[slot];
+            }
+            /// Obtain the component ID for this entity from the packed storage instead of the
+            /// hashed bindings of getComponentID. Both are updated by the same add and remove calls.
+            /// @param eID: ID of entity to search
+            /// @return Component ID if it exists, else ID_GENERATOR_NULL_ID
+            ComponentID findComponentID(EntityID eID) const {
+                ui32 slot = m_entitySlots.find(eID);
+                return slot == SPARSE_INDEX_NULL_SLOT ? ID_GENERATOR_NULL_ID : m_ids[slot];
+            }
+            /// @param eID: Entity ID
+            /// @return True if the entity has a component in this table
+            bool has(const EntityID& eID) const {
+                return m_entitySlots.contains(eID);
             }
 
             /// @return The blank component data
             const T& getDefaultData() const {
-                return _components[0].second;
+                return m_defaultData;
             }
 
             /// @return Iterator to the first pair of (entity ID, T)
-            typename ComponentList::iterator begin() {
-                // + 1 to skip the default element
-                return ++_components.begin();
+            iterator begin() {
+                return iterator(m_entities.data(), m_data.data());
             }
             /// @return Iterator to the end of component pairing list
-            typename ComponentList::iterator end() {
-                return _components.end();
+            iterator end() {
+                return iterator(m_entities.data() + m_entities.size(), m_data.data() + m_data.size());
             }
             /// @return Const iterator to the first pair of (entity ID, T)
-            typename ComponentList::const_iterator cbegin() const {
-                return ++_components.cbegin();
+            const_iterator cbegin() const {
+                return const_iterator(m_entities.data(), m_data.data());
             }
             /// @return Const iterator to the end of component pairing list
-            typename ComponentList::const_iterator cend() const {
-                return _components.cend();
+            const_iterator cend() const {
+                return const_iterator(m_entities.data() + m_entities.size(), m_data.data() + m_data.size());
             }
 
-            /// @return Reference to component list for iteration
-            operator const ComponentList& () const {
-                return _components;
-            }
+            /// @return Packed component data, getComponentListSize() elements long
+            T* getData() { return m_data.data(); }
+            /// @return Packed component data, getComponentListSize() elements long
+            const T* getData() const { return m_data.data(); }
+            /// @return Owner entity of each packed component, getComponentListSize() elements long
+            const EntityID* getEntities() const { return m_entities.data(); }
+            /// @return Component ID of each packed component, getComponentListSize() elements long
+            const ComponentID* getComponentIDs() const { return m_ids.data(); }
 
-            /// @return size of internal component list
-            size_t getComponentListSize() const { return _components.size(); }
+            /// @return Number of packed components
+            size_t getComponentListSize() const { return m_data.size(); }
+
+            /// Reserve storage so that adding components does not reallocate
+            /// @param n: Total number of components to hold
+            void reserve(size_t n) {
+                m_data.reserve(n);
+                m_entities.reserve(n);
+                m_ids.reserve(n);
+            }
 
         protected:
+            virtual void reserveComponents(size_t n) override {
+                reserve(n);
+            }
             virtual void addComponent(ComponentID cID, EntityID eID) override {
-                if (cID >= _components.size()) _components.resize(cID + 1);
-                _components[cID].first = eID;
-                _components[cID].second = getDefaultData();
+                pushComponent(cID, eID);
             }
             virtual void setComponent(ComponentID cID, EntityID eID) override {
-                _components[cID].first = eID;
-                _components[cID].second = getDefaultData();
+                pushComponent(cID, eID);
             }
 
             virtual void initComponent(ComponentID cID, EntityID eID) override {
                 // Empty
             }
+            /// Removes the component by moving the last packed component into its slot
+            /// @pre Overrides must call this after they are done with the component
             virtual void disposeComponent(ComponentID cID, EntityID eID) override {
-                // Empty
+                ui32 slot = m_componentSlots.find(cID);
+                if (slot == SPARSE_INDEX_NULL_SLOT) return;
+
+                ui32 last = (ui32)m_data.size() - 1;
+                if (slot != last) {
+                    m_data[slot] = std::move(m_data[last]);
+                    m_entities[slot] = m_entities[last];
+                    m_ids[slot] = m_ids[last];
+                    m_componentSlots.set(m_ids[slot], slot);
+                    m_entitySlots.set(m_entities[slot], slot);
+                }
+                m_data.pop_back();
+                m_entities.pop_back();
+                m_ids.pop_back();
+                m_componentSlots.erase(cID);
+                m_entitySlots.erase(eID);
+            }
+
+            /// Append a blank component to the packed arrays
+            /// @param cID: Component ID
+            /// @param eID: Owner entity
+            void pushComponent(ComponentID cID, EntityID eID) {
+                ui32 slot = (ui32)m_data.size();
+                m_data.push_back(m_defaultData);
+                m_entities.push_back(eID);
+                m_ids.push_back(cID);
+                m_componentSlots.set(cID, slot);
+                m_entitySlots.set(eID, slot);
             }
 
-            ComponentList _components; ///< A list of (entity ID, Component)
+            T m_defaultData; ///< Blank component data
+            std::vector<T> m_data; ///< Packed components
+            std::vector<EntityID> m_entities; ///< Owner of each packed component
+            std::vector<ComponentID> m_ids; ///< Component ID of each packed component
+            SparseIndex m_componentSlots; ///< Component ID -> packed slot
+            SparseIndex m_entitySlots; ///< Entity ID -> packed slot
         };
     }
 }
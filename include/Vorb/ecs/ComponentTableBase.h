@@ -15,12 +15,16 @@
 #ifndef ComponentTableBase_h__
 #define ComponentTableBase_h__
 
+#include <algorithm>
+
 #include "Entity.h"
 #include "../Events.hpp"
 #include "../IDGenerator.h"
 
 namespace vorb {
     namespace ecs {
+        class ECS;
+
         class ComponentTableBase {
             friend class ECS;
         public:
@@ -68,7 +72,13 @@ namespace vorb {
 
             Event<ComponentID, EntityID> onEntityAdded; ///< Called when an entity is added to this table
             Event<ComponentID, EntityID> onEntityRemoved; ///< Called when an entity is removed from this table
+            Event<const ComponentID*, const EntityID*, size_t> onEntitiesAdded; ///< Called when a chunk of entities is added to this table
         protected:
+            /// Reserve component storage ahead of a bulk addition
+            /// @param n: Total number of components that will be held
+            virtual void reserveComponents(size_t n) {
+                // Empty
+            }
             virtual void addComponent(ComponentID cID, EntityID eID) = 0;
             virtual void setComponent(ComponentID cID, EntityID eID) = 0;
 
@@ -84,10 +94,57 @@ namespace vorb {
             /// @param eID: Entity ID
             /// @return True if a component was removed
             bool remove(EntityID eID);
+            /// Registers components for a chunk of entities, firing onEntitiesAdded once. onEntityAdded
+            /// is also fired per entity while listeners that do not handle the batch are attached.
+            /// @param eIDs: Entity IDs
+            /// @param n: Number of entities
+            /// @param cIDs: Output array of registered component IDs
+            /// @param entities: Optional set of live entities that every ID must belong to
+            /// @throws std::runtime_error: When an entity is not live, already has a registered component
+            /// or is listed twice, before any is added
+            void addBulk(const EntityID* eIDs, size_t n, OUT ComponentID* cIDs, OPT const EntitySet* entities = nullptr) {
+                // Validate first so that a failed call leaves the table untouched
+                for (size_t i = 0; i < n; i++) {
+                    if (entities && entities->find(eIDs[i]) == entities->end()) {
+                        throw std::runtime_error("Entity does not exist");
+                    }
+                    if (_components.find(eIDs[i]) != _components.end()) {
+                        throw std::runtime_error("Entity already contains a component of this table");
+                    }
+                }
+                std::vector<EntityID> sorted(eIDs, eIDs + n);
+                std::sort(sorted.begin(), sorted.end());
+                if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+                    throw std::runtime_error("Entity is listed more than once in a bulk component addition");
+                }
+
+                _components.reserve(_components.size() + n);
+                reserveComponents(_components.size() + n);
+                for (size_t i = 0; i < n; i++) {
+                    bool shouldPush = false;
+                    ComponentID id = _genComponent.generate(&shouldPush);
+                    _components[eIDs[i]] = id;
+                    cIDs[i] = id;
+
+                    if (shouldPush) {
+                        addComponent(id, eIDs[i]);
+                    } else {
+                        setComponent(id, eIDs[i]);
+                    }
+                    initComponent(id, eIDs[i]);
+                }
+                onEntitiesAdded(cIDs, eIDs, n);
+
+                // Listeners that only know onEntityAdded (such as MultipleComponentSet) still see every component
+                if (onEntityAdded.getListenerCount() > m_numBatchedListeners) {
+                    for (size_t i = 0; i < n; i++) onEntityAdded(cIDs[i], eIDs[i]);
+                }
+            }
 
             TableID m_id; ///< ID within a system
             ComponentBindingSet _components; ///< List of (entity ID, component ID) pairings
             vcore::IDGenerator<ComponentID> _genComponent; ///< Unique ID generator
+            size_t m_numBatchedListeners = 0; ///< onEntityAdded listeners that do not need bulk additions per entity
         };
     }
 }
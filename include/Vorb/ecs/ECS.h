@@ -17,12 +17,14 @@
 
 #include "Entity.h"
 #include "BitTable.hpp"
+#include "ComponentTableBase.h"
 #include "../Events.hpp"
 #include "../IDGenerator.h"
 
 namespace vorb {
     namespace ecs {
-        class ComponentTableBase;
+        template<typename T> class ComponentTable;
+        template<typename... T> class ComponentQuery;
         
         typedef std::pair<nString, ComponentTableBase*> NamedComponent; ///< A component table paired with its name
         typedef std::unordered_map<nString, TableID> ComponentSet; ///< Mapping of names to component table IDs
@@ -54,18 +56,49 @@ namespace vorb {
             /// @param id: The entity's ID
             /// @return True if an entity was deleted
             bool deleteEntity(EntityID id);
-            /// Generate a chunk of entities
+            /// Generate a chunk of entities, firing onEntityAdded for each one
             /// @param n: Number of entities to generate
             /// @param ids: Pointer to output array of entities
             void genEntities(const size_t& n, EntityID* ids) {
                 for (size_t i = 0; i < n; i++) ids[i] = addEntity();
             }
+            /// Generate a chunk of entities, reserving storage once and firing onEntitiesAdded a
+            /// single time. onEntityAdded is only fired per entity if it has listeners.
+            /// @param n: Number of entities to generate
+            /// @param ids: Pointer to output array of entities
+            void addEntities(const size_t& n, OUT EntityID* ids) {
+                if (n == 0) return;
+                _entities.reserve(_entities.size() + n);
+                for (size_t i = 0; i < n; i++) {
+                    ids[i] = _genEntity.generate();
+                    _entities.emplace(ids[i]);
+                    if (ids[i] > m_eidHighest) m_eidHighest = ids[i];
+                }
+                if (m_entityComponents.getRowCount() <= m_eidHighest) {
+                    m_entityComponents.addRows(m_eidHighest + 1 - m_entityComponents.getRowCount());
+                }
+                onEntitiesAdded(ids, n);
+                if (onEntityAdded.getListenerCount() > 0) {
+                    for (size_t i = 0; i < n; i++) onEntityAdded(ids[i]);
+                }
+            }
 
             /// Add a component to an entity
             /// @param name: Friendly name of component
             /// @param id: Component owner entity
             /// @return ID of generated component
             ComponentID addComponent(nString name, EntityID id);
+            /// Add components of one table to many entities, reserving storage once and firing the
+            /// table's onEntitiesAdded a single time. The table's onEntityAdded is still fired per
+            /// entity while listeners other than this ECS's own bit trackers are attached to it.
+            /// @param tableID: ID of the component table
+            /// @param ids: Live component owner entities, none of which may already hold a component in the table
+            /// @param n: Number of entities
+            /// @param cIDs: Optional output array that receives the generated component IDs
+            /// @return False if there is no table with that ID
+            /// @throws std::runtime_error: When an entity does not exist, already has a component in the table
+            /// or is listed twice, before any component is added
+            bool addComponents(const TableID& tableID, const EntityID* ids, const size_t& n, OPT ComponentID* cIDs = nullptr);
             /// Remove a component from an entity
             /// @param name: Friendly name of component
             /// @param id: Component owner entity
@@ -99,13 +132,50 @@ namespace vorb {
             /// @return The component table
             ComponentTableBase* getComponentTable(TableID id) const;
 
+            /// Build a query over the entities that hold a component in every given table
+            /// Defined in ComponentQuery.hpp. Not thread-safe, but the returned query may be
+            /// iterated concurrently while no components are added or removed.
+            /// @param tables: Component tables that were added to this ECS
+            /// @return Query yielding the entity and its components from each table
+            template<typename... T>
+            ComponentQuery<T...> query(ComponentTable<T>&... tables);
+            /// @return Truth table of the components an entity holds (rows are entity IDs, columns are table IDs)
+            const BitTable& getEntityComponents() const {
+                return m_entityComponents;
+            }
+
             Event<EntityID> onEntityAdded; ///< Called when an entity is added to this system
+            Event<const EntityID*, size_t> onEntitiesAdded; ///< Called when addEntities adds a chunk of entities
             Event<EntityID> onEntityRemoved; ///< Called when an entity is removed from this system
             Event<NamedComponent> onComponentAdded; ///< Called when a component table is added to this system
         private:
             typedef std::pair<ComponentTableBase*, std::shared_ptr<Delegate<Sender, EntityID>>> ComponentSubscriber;
             typedef std::unordered_map<nString, ComponentSubscriber> ComponentSubscriberSet;
 
+            /// Keeps a table's column of m_entityComponents in sync with its components
+            struct TableBitHook {
+                TableBitHook(BitTable* bits, TableID id) :
+                    bits(bits),
+                    id(id) {
+                    // Empty
+                }
+
+                void onAdded(Sender s, ComponentID cID, EntityID eID) {
+                    if (bits->getRowCount() <= eID) bits->addRows(eID + 1 - bits->getRowCount());
+                    bits->setTrue(eID, id);
+                }
+                void onRemoved(Sender s, ComponentID cID, EntityID eID) {
+                    if (eID < bits->getRowCount()) bits->setFalse(eID, id);
+                }
+
+                BitTable* bits; ///< Truth table of the owning ECS
+                TableID id; ///< Column of the tracked table
+            };
+
+            /// Start tracking component bits for tables that have been added since the last call
+            /// Component tables must not be modified after this ECS is destroyed.
+            void trackComponentTables();
+
             EntitySet _entities; ///< List of entities
             EntityID m_eidHighest = 0; ///< Highest generated entity ID
             BitTable m_entityComponents; ///< Truth table for components that an entity holds
@@ -113,7 +183,31 @@ namespace vorb {
             vcore::IDGenerator<EntityID> _genEntity; ///< Unique ID generator for entities
             ComponentSet _components; ///< List of component tables
             ComponentList m_componentList; ///< Component tables organized by their id
+            std::vector<std::unique_ptr<TableBitHook>> m_tableBitHooks; ///< Bit trackers organized by table id
         };
+
+        inline bool ECS::addComponents(const TableID& tableID, const EntityID* ids, const size_t& n, OPT ComponentID* cIDs /*= nullptr*/) {
+            ComponentTableBase* table = getComponentTable(tableID);
+            if (!table) return false;
+            if (n == 0) return true;
+
+            std::vector<ComponentID> generated;
+            if (!cIDs) {
+                generated.resize(n);
+                cIDs = generated.data();
+            }
+            table->addBulk(ids, n, cIDs, &_entities);
+
+            // Grow the truth table once, then mark every new component
+            EntityID highest = 0;
+            for (size_t i = 0; i < n; i++) highest = std::max(highest, ids[i]);
+            while (m_entityComponents.getBitColumnCount() <= tableID) m_entityComponents.addColumn();
+            if (m_entityComponents.getRowCount() <= highest) {
+                m_entityComponents.addRows(highest + 1 - m_entityComponents.getRowCount());
+            }
+            for (size_t i = 0; i < n; i++) m_entityComponents.setTrue(ids[i], tableID);
+            return true;
+        }
     }
 }
 namespace vecs = vorb::ecs;
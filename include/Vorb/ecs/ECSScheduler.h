@@ -0,0 +1,269 @@
+///
+/// ECSScheduler.h
+/// Vorb Engine
+///
+/// Created by agent on 17 Oct 2026
+/// Copyright 2014 Regrowth Studios
+/// All Rights Reserved
+///
+/// Summary:
+/// Runs ECS systems concurrently when their component access does not conflict
+///
+
+#pragma once
+
+#ifndef ECSScheduler_h__
+#define ECSScheduler_h__
+
+#include "ComponentTableBase.h"
+#include "../ScopedTiming.hpp"
+#include "../ThreadPool.h"
+
+namespace vorb {
+    namespace ecs {
+        typedef std::vector<TableID> TableIDList; ///< A list of component table IDs
+
+        /// A unit of per-frame work that declares which component tables it reads and writes
+        ///
+        /// Systems must not add or remove components while the scheduler runs them. The chunks
+        /// of one system may run concurrently, so a chunk may only write components of the
+        /// work items it was given.
+        class ECSSystem {
+        public:
+            virtual ~ECSSystem() {
+                // Empty
+            }
+
+            /// Called on the scheduling thread at the start of each frame, before any system runs.
+            /// Building queries belongs here.
+            /// @return Number of work items, split into chunks of getChunkSize() items
+            virtual size_t prepare() {
+                return 1;
+            }
+            /// Process a range of work items
+            /// @param first: First work item
+            /// @param last: One past the last work item
+            virtual void update(size_t first, size_t last) = 0;
+
+            /// Declare that this system reads a table
+            /// @param table: Component table that was added to an ECS
+            void addRead(const ComponentTableBase* table) {
+                m_reads.push_back(table->getID());
+            }
+            /// Declare that this system reads and writes a table
+            /// @param table: Component table that was added to an ECS
+            void addWrite(const ComponentTableBase* table) {
+                m_writes.push_back(table->getID());
+            }
+            /// @param chunkSize: Largest number of work items handed to one task
+            void setChunkSize(size_t chunkSize) {
+                m_chunkSize = chunkSize > 0 ? chunkSize : 1;
+            }
+
+            /// Getters
+            const TableIDList& getReads() const { return m_reads; }
+            const TableIDList& getWrites() const { return m_writes; }
+            const size_t& getChunkSize() const { return m_chunkSize; }
+            /// @return Time spent in update, sampled once per chunk
+            MTDetailedSamplerContext& getTiming() { return m_timing; }
+        private:
+            TableIDList m_reads; ///< Tables that are only read
+            TableIDList m_writes; ///< Tables that are written
+            size_t m_chunkSize = 4096; ///< Work items per task
+            MTDetailedSamplerContext m_timing; ///< Update time samples
+        };
+
+        /// Runs systems on a ThreadPool in an order equivalent to running them serially
+        ///
+        /// Every frame, two systems conflict if one writes a table the other reads or writes.
+        /// A system waits for every earlier conflicting system, while non-conflicting systems
+        /// and the chunks of a single system run concurrently.
+        /// @tparam T: Worker data type of the ThreadPool
+        template<typename T>
+        class ECSScheduler : public vcore::ITaskRecycler<T> {
+        public:
+            ECSScheduler() {
+                // Empty
+            }
+
+            /// Add a system to the end of the frame order
+            /// @param system: System that outlives this scheduler or its removal
+            void addSystem(ECSSystem* system) {
+                m_nodes.emplace_back(new SystemNode(system, this));
+            }
+            /// Remove a system from the frame order
+            /// @param system: A previously added system
+            /// @return True if the system was removed
+            bool removeSystem(ECSSystem* system) {
+                for (auto it = m_nodes.begin(); it != m_nodes.end(); it++) {
+                    if ((*it)->system != system) continue;
+                    m_nodes.erase(it);
+                    return true;
+                }
+                return false;
+            }
+
+            /// Run every system once on the calling thread, in order
+            void update() {
+                prepareSystems();
+                for (auto& node : m_nodes) {
+                    for (ui32 c = 0; c < node->numChunks; c++) node->chunks[c]->execute(nullptr);
+                }
+            }
+            /// Run every system once on a pool and block until they are done
+            ///
+            /// The calling thread only waits, so this must be called from outside the pool. Called
+            /// from one of its workers, that worker spins instead of running tasks, and with a single
+            /// worker the frame never finishes. Use update() to run systems from inside a task.
+            /// @param pool: Pool whose workers execute the systems, not including the calling thread
+            /// @param priority: Lane of the submitted tasks
+            void update(vcore::ThreadPool<T>* pool, vcore::TaskPriority priority = vcore::TaskPriority::HIGH) {
+                prepareSystems();
+                buildConflictMasks();
+
+                size_t numTasks = 0;
+                m_ready.clear();
+                for (size_t i = 0; i < m_nodes.size(); i++) {
+                    SystemNode& node = *m_nodes[i];
+                    for (ui32 c = 0; c < node.numChunks; c++) {
+                        node.chunks[c]->setPriority(priority);
+                        node.chunks[c]->addContinuation(&node.join);
+                    }
+                    node.join.setPriority(priority);
+                    numTasks += node.numChunks + 1;
+
+                    // Entry tasks wait on the joins of earlier conflicting systems
+                    bool hasDependency = false;
+                    for (size_t j = 0; j < i; j++) {
+                        if (!conflicts(i, j)) continue;
+                        hasDependency = true;
+                        if (node.numChunks == 0) {
+                            node.join.addDependency(&m_nodes[j]->join);
+                        } else {
+                            for (ui32 c = 0; c < node.numChunks; c++) node.chunks[c]->addDependency(&m_nodes[j]->join);
+                        }
+                    }
+                    if (hasDependency) continue;
+                    if (node.numChunks == 0) {
+                        m_ready.push_back(&node.join);
+                    } else {
+                        for (ui32 c = 0; c < node.numChunks; c++) m_ready.push_back(node.chunks[c].get());
+                    }
+                }
+                if (numTasks == 0) return;
+
+                m_numRecycled.store(0, std::memory_order_relaxed);
+                pool->addTasks(m_ready.data(), m_ready.size());
+                // Tasks are reused next frame, so wait until the workers have let go of all of them
+                while (m_numRecycled.load(std::memory_order_acquire) != numTasks) std::this_thread::yield();
+            }
+
+            /// Called by a worker once it is done with a task
+            virtual void recycle(vcore::IThreadPoolTask<T>* task, i32 workerIndex = -1) override {
+                m_numRecycled.fetch_add(1, std::memory_order_acq_rel);
+            }
+
+            /// @return Number of scheduled systems
+            size_t getNumSystems() const {
+                return m_nodes.size();
+            }
+        private:
+            VORB_NON_COPYABLE(ECSScheduler);
+
+            /// Runs a range of a system's work items
+            class ChunkTask : public vcore::IThreadPoolTask<T> {
+            public:
+                ChunkTask(ECSSystem* system, vcore::ITaskRecycler<T>* recycler) : vcore::IThreadPoolTask<T>(false),
+                    system(system) {
+                    this->setRecycler(recycler);
+                }
+                virtual void execute(T* workerData) override {
+                    VORB_SAMPLE_SCOPE(system->getTiming());
+                    system->update(first, last);
+                }
+
+                ECSSystem* system; ///< Owner
+                size_t first = 0; ///< First work item
+                size_t last = 0; ///< One past the last work item
+            };
+            /// Completes once every chunk of a system is done, releasing later conflicting systems
+            class JoinTask : public vcore::IThreadPoolTask<T> {
+            public:
+                JoinTask(vcore::ITaskRecycler<T>* recycler) : vcore::IThreadPoolTask<T>(false) {
+                    this->setRecycler(recycler);
+                }
+                virtual void execute(T* workerData) override {
+                    // Empty
+                }
+            };
+            /// Scheduling state of one system
+            struct SystemNode {
+                SystemNode(ECSSystem* system, vcore::ITaskRecycler<T>* recycler) :
+                    system(system),
+                    join(recycler) {
+                    // Empty
+                }
+
+                ECSSystem* system; ///< The scheduled system
+                std::vector<std::unique_ptr<ChunkTask>> chunks; ///< Chunk tasks, reused across frames
+                ui32 numChunks = 0; ///< Chunk tasks used this frame
+                JoinTask join; ///< Joins the chunks
+                std::vector<ui64> readMask; ///< Bits of read tables
+                std::vector<ui64> writeMask; ///< Bits of written tables
+            };
+
+            /// Ask every system for its work and split it into chunks
+            void prepareSystems() {
+                for (auto& node : m_nodes) {
+                    size_t numItems = node->system->prepare();
+                    size_t chunkSize = node->system->getChunkSize();
+                    node->numChunks = (ui32)((numItems + chunkSize - 1) / chunkSize);
+                    while (node->chunks.size() < node->numChunks) {
+                        node->chunks.emplace_back(new ChunkTask(node->system, this));
+                    }
+                    for (ui32 c = 0; c < node->numChunks; c++) {
+                        node->chunks[c]->first = c * chunkSize;
+                        node->chunks[c]->last = std::min(numItems, (c + 1) * chunkSize);
+                    }
+                }
+            }
+
+            /// Convert declared table accesses into bitsets, since declarations may change between frames
+            void buildConflictMasks() {
+                for (auto& node : m_nodes) {
+                    setMask(node->readMask, node->system->getReads());
+                    setMask(node->writeMask, node->system->getWrites());
+                }
+            }
+            static void setMask(std::vector<ui64>& mask, const TableIDList& ids) {
+                std::fill(mask.begin(), mask.end(), 0);
+                for (auto& id : ids) {
+                    if ((id >> 6) >= mask.size()) mask.resize((id >> 6) + 1, 0);
+                    mask[id >> 6] |= 1ull << (id & 63);
+                }
+            }
+            static bool intersects(const std::vector<ui64>& a, const std::vector<ui64>& b) {
+                size_t n = std::min(a.size(), b.size());
+                for (size_t i = 0; i < n; i++) {
+                    if (a[i] & b[i]) return true;
+                }
+                return false;
+            }
+            /// @return True if systems i and j may not run concurrently
+            bool conflicts(size_t i, size_t j) const {
+                const SystemNode& a = *m_nodes[i];
+                const SystemNode& b = *m_nodes[j];
+                return intersects(a.writeMask, b.writeMask) ||
+                    intersects(a.writeMask, b.readMask) ||
+                    intersects(a.readMask, b.writeMask);
+            }
+
+            std::vector<std::unique_ptr<SystemNode>> m_nodes; ///< Systems in frame order
+            std::vector<vcore::IThreadPoolTask<T>*> m_ready; ///< Tasks without dependencies this frame
+            std::atomic<size_t> m_numRecycled = ATOMIC_VAR_INIT(0); ///< Tasks the workers are done with
+        };
+    }
+}
+namespace vecs = vorb::ecs;
+
+#endif // ECSScheduler_h__
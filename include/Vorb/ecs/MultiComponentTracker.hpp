@@ -20,6 +20,7 @@
 namespace vorb {
     namespace ecs {
         /// Tracks entities in specified component sets as well as their component IDs
+        /// For iteration without per-entity hashing, prefer ECS::query (ComponentQuery.hpp)
         template<size_t N> 
         class MultiComponentTracker : public MultipleComponentSet {
         public:
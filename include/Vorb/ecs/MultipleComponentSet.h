@@ -23,6 +23,7 @@ namespace vorb {
         class ComponentTableBase;
 
         /// Listener class that tracks entities that meet component requirements
+        /// For iteration without per-entity hashing, prefer ECS::query (ComponentQuery.hpp)
         class MultipleComponentSet {
         public:
             /// Default constructor which initializes events
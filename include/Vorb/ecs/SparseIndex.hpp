@@ -0,0 +1,88 @@
+///
+/// SparseIndex.hpp
+/// Vorb Engine
+///
+/// Created by agent on 17 Oct 2026
+/// Copyright 2014 Regrowth Studios
+/// All Rights Reserved
+///
+/// Summary:
+/// Paged mapping from sparse IDs to dense array slots
+///
+
+#pragma once
+
+#ifndef SparseIndex_hpp__
+#define SparseIndex_hpp__
+
+namespace vorb {
+    namespace ecs {
+#define SPARSE_INDEX_NULL_SLOT 0xFFFFFFFFu
+
+        /// Maps sparse numeric IDs (entities, components) to slots of a packed array.
+        /// Pages of slots are allocated on first write, so an ID range with large gaps
+        /// only pays for the pages it touches. Lookups are two array reads with no hashing.
+        class SparseIndex {
+        public:
+            static const ui32 PAGE_BITS = 10; ///< log2 of the IDs held by one page
+            static const ui32 PAGE_SIZE = 1 << PAGE_BITS; ///< IDs held by one page
+
+            /// Find the slot of an ID
+            /// @param id: Sparse ID
+            /// @return Dense slot, or SPARSE_INDEX_NULL_SLOT if the ID is not mapped
+            ui32 find(const ui32& id) const {
+                ui32 page = id >> PAGE_BITS;
+                if (page >= m_pages.size() || !m_pages[page]) return SPARSE_INDEX_NULL_SLOT;
+                return m_pages[page][id & (PAGE_SIZE - 1)];
+            }
+            /// @param id: Sparse ID
+            /// @return True if the ID is mapped to a slot
+            bool contains(const ui32& id) const {
+                return find(id) != SPARSE_INDEX_NULL_SLOT;
+            }
+
+            /// Map an ID to a slot, allocating its page if needed
+            /// @param id: Sparse ID
+            /// @param slot: Dense slot
+            void set(const ui32& id, const ui32& slot) {
+                ui32 page = id >> PAGE_BITS;
+                if (page >= m_pages.size()) m_pages.resize(page + 1);
+                if (!m_pages[page]) allocPage(page);
+                m_pages[page][id & (PAGE_SIZE - 1)] = slot;
+            }
+            /// Unmap an ID
+            /// @param id: Sparse ID
+            void erase(const ui32& id) {
+                ui32 page = id >> PAGE_BITS;
+                if (page < m_pages.size() && m_pages[page]) m_pages[page][id & (PAGE_SIZE - 1)] = SPARSE_INDEX_NULL_SLOT;
+            }
+
+            /// Allocate the pages that cover every ID below a bound
+            /// @param maxID: Exclusive upper bound of the IDs that will be mapped
+            void reserve(const ui32& maxID) {
+                if (maxID == 0) return;
+                ui32 pages = ((maxID - 1) >> PAGE_BITS) + 1;
+                if (pages > m_pages.size()) m_pages.resize(pages);
+                for (ui32 i = 0; i < pages; i++) {
+                    if (!m_pages[i]) allocPage(i);
+                }
+            }
+            /// Release all pages
+            void clear() {
+                std::vector<std::unique_ptr<ui32[]>>().swap(m_pages);
+            }
+        private:
+            /// Allocate a page with every slot unmapped
+            /// @param page: Index of the page
+            void allocPage(const ui32& page) {
+                m_pages[page].reset(new ui32[PAGE_SIZE]);
+                std::fill(m_pages[page].get(), m_pages[page].get() + PAGE_SIZE, SPARSE_INDEX_NULL_SLOT);
+            }
+
+            std::vector<std::unique_ptr<ui32[]>> m_pages; ///< Lazily allocated pages of slots
+        };
+    }
+}
+namespace vecs = vorb::ecs;
+
+#endif // SparseIndex_hpp__
@@ -0,0 +1,122 @@
+#include <Vorb/stdafx.h>
+#include <Vorb/voxel/IntervalTree.h>
+#include <Vorb/ScopedTiming.hpp>
+
+#define CHUNK_SIZE 32768
+#define ITERATIONS 2000
+#define EDITS_PER_BATCH 256
+
+/// Builds a chunk that looks like terrain: solid layers with a noisy surface
+void buildTerrain(IntervalTree<ui16>& tree) {
+    std::vector<IntervalTree<ui16>::LNode> runs;
+    runs.emplace_back(0, 32 * 32 * 12, 1);
+    ui32 seed = 7;
+    ui16 index = 32 * 32 * 12;
+    while (index < 32 * 32 * 20) {
+        seed = seed * 1664525u + 1013904223u;
+        ui16 length = 1 + (seed >> 16) % 24;
+        runs.emplace_back(index, length, (ui16)(2 + (seed >> 8) % 4));
+        index += length;
+    }
+    runs.emplace_back(index, CHUNK_SIZE - index, 0);
+    tree.initFromSortedArray(runs);
+}
+
+/// Recompression through an intermediate list of runs
+void compressThroughRuns(IntervalTree<ui16>& tree, const ui16* buffer) {
+    std::vector<IntervalTree<ui16>::LNode> runs;
+    runs.emplace_back(0, 1, buffer[0]);
+    for (ui16 i = 1; i < CHUNK_SIZE; i++) {
+        if (buffer[i] == runs.back().data) {
+            runs.back().length++;
+        } else {
+            runs.emplace_back(i, 1, buffer[i]);
+        }
+    }
+    tree.initFromSortedArray(runs);
+}
+
+/// The original uncompressTraversal, kept here as the baseline: recursive, one voxel at a time
+void uncompressTraversal(IntervalTree<ui16>& tree, int index, int& bufferIndex, ui16* buffer) {
+    if (tree[index].left != -1) {
+        uncompressTraversal(tree, tree[index].left, bufferIndex, buffer);
+    }
+    for (int i = 0; i < tree[index].length; i++) {
+        buffer[bufferIndex++] = tree[index].data;
+    }
+    if (tree[index].right != -1) {
+        uncompressTraversal(tree, tree[index].right, bufferIndex, buffer);
+    }
+}
+void uncompressRecursive(IntervalTree<ui16>& tree, ui16* buffer) {
+    if (tree.size() == 0) return;
+    int root = 0;
+    while (tree[root].parent != -1) root = tree[root].parent;
+    int bufferIndex = 0;
+    uncompressTraversal(tree, root, bufferIndex, buffer);
+}
+
+int main(int argc, char** argv) {
+    std::vector<ui16> buffer(CHUNK_SIZE);
+
+    IntervalTree<ui16> tree;
+    buildTerrain(tree);
+    printf("Terrain chunk: %d intervals\n", tree.size());
+
+    vorb::AccumulationSamplerContext recursive, bulk;
+    for (ui32 i = 0; i < ITERATIONS; i++) {
+        {
+            VORB_SAMPLE_SCOPE(recursive);
+            uncompressRecursive(tree, buffer.data());
+        }
+        {
+            VORB_SAMPLE_SCOPE(bulk);
+            tree.uncompressIntoBuffer(buffer.data());
+        }
+    }
+    printf("%-24s %12.3f us/chunk\n", "uncompress recursive", recursive.getAccumulatedMilliSeconds() * 1000.0 / ITERATIONS);
+    printf("%-24s %12.3f us/chunk\n", "uncompress bulk", bulk.getAccumulatedMilliSeconds() * 1000.0 / ITERATIONS);
+
+    vorb::AccumulationSamplerContext throughRuns, direct;
+    IntervalTree<ui16> recompressed;
+    for (ui32 i = 0; i < ITERATIONS; i++) {
+        {
+            VORB_SAMPLE_SCOPE(throughRuns);
+            compressThroughRuns(recompressed, buffer.data());
+        }
+        {
+            VORB_SAMPLE_SCOPE(direct);
+            recompressed.initFromBuffer(buffer.data(), CHUNK_SIZE);
+        }
+    }
+    printf("%-24s %12.3f us/chunk\n", "compress through runs", throughRuns.getAccumulatedMilliSeconds() * 1000.0 / ITERATIONS);
+    printf("%-24s %12.3f us/chunk\n", "initFromBuffer", direct.getAccumulatedMilliSeconds() * 1000.0 / ITERATIONS);
+
+    // Scattered single voxel edits, like an explosion carving out the surface
+    std::vector<IntervalTree<ui16>::LNode> edits;
+    ui32 seed = 11;
+    ui16 index = 32 * 32 * 10;
+    for (ui32 i = 0; i < EDITS_PER_BATCH; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        index += 1 + (seed >> 16) % 48;
+        edits.emplace_back(index, 1, 0);
+    }
+
+    vorb::AccumulationSamplerContext inserts, batched;
+    for (ui32 i = 0; i < ITERATIONS / 10; i++) {
+        IntervalTree<ui16> a, b;
+        buildTerrain(a);
+        buildTerrain(b);
+        {
+            VORB_SAMPLE_SCOPE(inserts);
+            for (auto& edit : edits) a.insert(edit.start, edit.data);
+        }
+        {
+            VORB_SAMPLE_SCOPE(batched);
+            b.insertSorted(edits);
+        }
+    }
+    printf("%-24s %12.3f us/batch\n", "insert per voxel", inserts.getAccumulatedMilliSeconds() * 10000.0 / ITERATIONS);
+    printf("%-24s %12.3f us/batch\n", "insertSorted", batched.getAccumulatedMilliSeconds() * 10000.0 / ITERATIONS);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <Vorb/stdafx.h>
+#include <Vorb/PtrRecycler.hpp>
+#include <Vorb/ConcurrentPtrRecycler.hpp>
+#include <Vorb/ScopedTiming.hpp>
+
+#define OPS_PER_THREAD 1000000
+#define LIVE_OBJECTS 64
+
+struct ChunkLike {
+    ChunkLike() {}
+    ChunkLike(ui32 i) : id(i) {}
+    ui32 id = 0;
+    ui16 data[64];
+};
+
+/// Each thread keeps a small working set alive and keeps swapping objects in and out of it
+template<typename Create, typename Recycle>
+void churn(ui32 seed, Create create, Recycle recycle) {
+    ChunkLike* live[LIVE_OBJECTS];
+    for (ui32 i = 0; i < LIVE_OBJECTS; i++) live[i] = create(i);
+    for (ui32 i = 0; i < OPS_PER_THREAD; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        ui32 slot = (seed >> 16) % LIVE_OBJECTS;
+        recycle(live[slot]);
+        live[slot] = create(i);
+    }
+    for (ui32 i = 0; i < LIVE_OBJECTS; i++) recycle(live[i]);
+}
+
+template<typename F>
+f64 runThreads(ui32 numThreads, F f) {
+    vorb::AccumulationSamplerContext timing;
+    {
+        VORB_SAMPLE_SCOPE(timing);
+        std::vector<std::thread> threads;
+        for (ui32 t = 0; t < numThreads; t++) threads.emplace_back(f, t + 1);
+        for (auto& t : threads) t.join();
+    }
+    return timing.getAccumulatedMilliSeconds();
+}
+
+int main(int argc, char** argv) {
+    ui32 maxThreads = std::thread::hardware_concurrency();
+    if (maxThreads == 0) maxThreads = 4;
+
+    printf("%8s %16s %16s\n", "threads", "mutex (ms)", "concurrent (ms)");
+    for (ui32 threads = 1; threads <= maxThreads; threads <<= 1) {
+        PtrRecycler<ChunkLike> locked;
+        std::mutex lock;
+        f64 tLocked = runThreads(threads, [&] (ui32 seed) {
+            churn(seed, [&] (ui32 i) {
+                std::lock_guard<std::mutex> l(lock);
+                return locked.create(i);
+            }, [&] (ChunkLike* c) {
+                std::lock_guard<std::mutex> l(lock);
+                locked.recycle(c);
+            });
+        });
+
+        ConcurrentPtrRecycler<ChunkLike> concurrent;
+        f64 tConcurrent = runThreads(threads, [&] (ui32 seed) {
+            churn(seed, [&] (ui32 i) {
+                return concurrent.create(i);
+            }, [&] (ChunkLike* c) {
+                concurrent.recycle(c);
+            });
+        });
+
+        ConcurrentPtrRecyclerStats stats = concurrent.getStats();
+        printf("%8u %16.3f %16.3f   (allocations %llu, magazine hits %llu, depot transfers %llu)\n",
+               threads, tLocked, tConcurrent,
+               (unsigned long long)stats.allocations, (unsigned long long)stats.magazineHits,
+               (unsigned long long)stats.depotTransfers);
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <Vorb/stdafx.h>
+#include <Vorb/ThreadPool.h>
+#include <Vorb/ScopedTiming.hpp>
+
+#define CHUNK_SIZE 32768
+#define NUM_TASKS 20000
+
+struct WorkerData {
+    volatile bool stop;
+    ui16 scratch[CHUNK_SIZE];
+};
+
+/// Mimics generation (full chunk), meshing (half chunk) and small bookkeeping tasks
+class ChunkLikeTask : public vcore::IThreadPoolTask<WorkerData> {
+public:
+    ChunkLikeTask() : vcore::IThreadPoolTask<WorkerData>(true) {}
+
+    void init(ui32 work, ui32 seed) {
+        m_work = work;
+        m_seed = seed;
+        m_isFinished = false;
+    }
+
+    virtual void execute(WorkerData* workerData) override {
+        ui32 s = m_seed;
+        for (ui32 i = 0; i < m_work; i++) {
+            s = s * 1664525u + 1013904223u;
+            workerData->scratch[i] = (ui16)(s >> 16);
+        }
+        m_seed = s;
+    }
+private:
+    ui32 m_work = 0;
+    ui32 m_seed = 0;
+};
+
+f64 runMix(vcore::ThreadPoolScheduler scheduler, ui32 workers, std::vector<ChunkLikeTask>& tasks) {
+    vcore::ThreadPool<WorkerData> pool;
+    pool.init(workers, scheduler);
+
+    std::vector<vcore::IThreadPoolTask<WorkerData>*> ptrs(tasks.size());
+    for (size_t i = 0; i < tasks.size(); i++) {
+        ui32 kind = i % 10;
+        tasks[i].init(kind < 2 ? CHUNK_SIZE : (kind < 6 ? CHUNK_SIZE / 2 : 256), (ui32)i);
+        ptrs[i] = &tasks[i];
+    }
+
+    vorb::AccumulationSamplerContext timing;
+    {
+        VORB_SAMPLE_SCOPE(timing);
+        // Submit one at a time to stress the queue heads like the chunk manager does
+        for (auto& t : ptrs) pool.addTask(t);
+
+        size_t finished = 0;
+        vcore::IThreadPoolTask<WorkerData>* buffer[256];
+        while (finished < ptrs.size()) {
+            size_t n = pool.getFinishedTasks(buffer, 256);
+            if (n == 0) std::this_thread::yield();
+            finished += n;
+        }
+    }
+
+    pool.destroy();
+    return timing.getAccumulatedMilliSeconds();
+}
+
+int main(int argc, char** argv) {
+    std::vector<ChunkLikeTask> tasks(NUM_TASKS);
+
+    ui32 maxWorkers = std::thread::hardware_concurrency();
+    if (maxWorkers == 0) maxWorkers = 4;
+
+    printf("%8s %16s %16s\n", "workers", "shared (ms)", "stealing (ms)");
+    for (ui32 workers = 1; workers <= maxWorkers; workers <<= 1) {
+        f64 shared = runMix(vcore::ThreadPoolScheduler::SHARED_QUEUE, workers, tasks);
+        f64 stealing = runMix(vcore::ThreadPoolScheduler::WORK_STEALING, workers, tasks);
+        printf("%8u %16.3f %16.3f\n", workers, shared, stealing);
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include <Vorb/stdafx.h>
+#include <Vorb/voxel/VoxelLightEngine.h>
+#include <Vorb/ScopedTiming.hpp>
+
+#define CHUNK_WIDTH 32
+#define CHUNK_SIZE (CHUNK_WIDTH * CHUNK_WIDTH * CHUNK_WIDTH)
+#define GRID_X 4
+#define GRID_Y 2
+#define GRID_Z 4
+#define NUM_CHUNKS (GRID_X * GRID_Y * GRID_Z)
+#define NUM_TORCHES 256
+#define NUM_EDITS 64
+
+struct WorkerData {
+    volatile bool stop;
+};
+
+/// Hilly terrain with caves, torches and the light arrays of every chunk
+class LightWorld {
+public:
+    LightWorld() {
+        for (ui32 i = 0; i < NUM_CHUNKS; i++) {
+            ui32 gx = i % GRID_X, gz = (i / GRID_X) % GRID_Z, gy = i / (GRID_X * GRID_Z);
+            chunks[i].opacity.assign(CHUNK_SIZE, 0);
+            chunks[i].emission.assign(CHUNK_SIZE, 0);
+            for (auto& l : chunks[i].light) l.assign(CHUNK_SIZE, 0);
+
+            vvox::LightVolume& v = volumes[i];
+            v.opacity = chunks[i].opacity.data();
+            v.emission = chunks[i].emission.data();
+            for (size_t c = 0; c < vvox::NUM_LIGHT_CHANNELS; c++) v.light[c] = chunks[i].light[c].data();
+            v.neighbors[(size_t)vvox::Cardinal::X_NEG] = gx > 0 ? &volumes[i - 1] : nullptr;
+            v.neighbors[(size_t)vvox::Cardinal::X_POS] = gx < GRID_X - 1 ? &volumes[i + 1] : nullptr;
+            v.neighbors[(size_t)vvox::Cardinal::Z_NEG] = gz > 0 ? &volumes[i - GRID_X] : nullptr;
+            v.neighbors[(size_t)vvox::Cardinal::Z_POS] = gz < GRID_Z - 1 ? &volumes[i + GRID_X] : nullptr;
+            v.neighbors[(size_t)vvox::Cardinal::Y_NEG] = gy > 0 ? &volumes[i - GRID_X * GRID_Z] : nullptr;
+            v.neighbors[(size_t)vvox::Cardinal::Y_POS] = gy < GRID_Y - 1 ? &volumes[i + GRID_X * GRID_Z] : nullptr;
+        }
+
+        for (ui32 y = 0; y < GRID_Y * CHUNK_WIDTH; y++) {
+            for (ui32 z = 0; z < GRID_Z * CHUNK_WIDTH; z++) {
+                for (ui32 x = 0; x < GRID_X * CHUNK_WIDTH; x++) {
+                    ui32 height = 36 + (ui32)(10.0 * sin(x * 0.07) * cos(z * 0.05) + 6.0 * sin((x + z) * 0.03));
+                    bool cave = sin(x * 0.2) * sin(y * 0.25) * sin(z * 0.2) > 0.35;
+                    if (y < height && !cave) opacity(x, y, z) = 15;
+                }
+            }
+        }
+    }
+
+    ui8& opacity(ui32 x, ui32 y, ui32 z) {
+        return chunks[chunkIndex(x, y, z)].opacity[voxelIndex(x, y, z)];
+    }
+    vvox::LightVolume* volume(ui32 x, ui32 y, ui32 z) {
+        return &volumes[chunkIndex(x, y, z)];
+    }
+    static ui32 chunkIndex(ui32 x, ui32 y, ui32 z) {
+        return ((y / CHUNK_WIDTH) * GRID_Z + z / CHUNK_WIDTH) * GRID_X + x / CHUNK_WIDTH;
+    }
+    static ui32 voxelIndex(ui32 x, ui32 y, ui32 z) {
+        return ((y % CHUNK_WIDTH) * CHUNK_WIDTH + z % CHUNK_WIDTH) * CHUNK_WIDTH + x % CHUNK_WIDTH;
+    }
+
+    /// Queues sunlight and torches in clear voxels
+    void seed(vvox::VoxelLightEngine& engine) {
+        for (ui32 i = 0; i < NUM_CHUNKS; i++) {
+            for (auto& l : chunks[i].light) l.assign(CHUNK_SIZE, 0);
+            if (i >= NUM_CHUNKS - GRID_X * GRID_Z) engine.seedSunlight(&volumes[i]);
+        }
+        ui32 s = 12345;
+        for (ui32 n = 0; n < NUM_TORCHES;) {
+            s = s * 1664525u + 1013904223u;
+            ui32 x = (s >> 8) % (GRID_X * CHUNK_WIDTH), y = (s >> 4) % (GRID_Y * CHUNK_WIDTH), z = (s >> 16) % (GRID_Z * CHUNK_WIDTH);
+            if (opacity(x, y, z) != 0) continue;
+            chunks[chunkIndex(x, y, z)].emission[voxelIndex(x, y, z)] = 14;
+            engine.addLight(volume(x, y, z), vvox::LightChannel::BLOCK, voxelIndex(x, y, z), 14);
+            n++;
+        }
+    }
+
+    /// Queues a batch of dug out and placed blocks
+    void edit(vvox::VoxelLightEngine& engine, ui32 seed) {
+        ui32 s = seed;
+        for (ui32 n = 0; n < NUM_EDITS; n++) {
+            s = s * 1664525u + 1013904223u;
+            ui32 x = (s >> 8) % (GRID_X * CHUNK_WIDTH), y = 24 + (s >> 4) % 32, z = (s >> 16) % (GRID_Z * CHUNK_WIDTH);
+            ui8& o = opacity(x, y, z);
+            if (o != 0) {
+                o = 0;
+                engine.relight(volume(x, y, z), voxelIndex(x, y, z));
+            } else if (chunks[chunkIndex(x, y, z)].emission[voxelIndex(x, y, z)] == 0) {
+                o = 15;
+                engine.removeLight(volume(x, y, z), vvox::LightChannel::SUN, voxelIndex(x, y, z));
+                engine.removeLight(volume(x, y, z), vvox::LightChannel::BLOCK, voxelIndex(x, y, z));
+            }
+        }
+    }
+
+    struct Chunk {
+        std::vector<ui8> opacity;
+        std::vector<ui8> emission;
+        std::vector<ui8> light[vvox::NUM_LIGHT_CHANNELS];
+    };
+    Chunk chunks[NUM_CHUNKS];
+    vvox::LightVolume volumes[NUM_CHUNKS];
+};
+
+template<typename F>
+void measure(const char* name, vvox::VoxelLightEngine& engine, F run) {
+    engine.resetStats();
+    vorb::AccumulationSamplerContext timing;
+    run(timing);
+    vvox::LightEngineStats stats = engine.getStats();
+    ui64 voxels = stats.voxelsLit + stats.voxelsCleared;
+    printf("%-28s %12llu voxels %10.3f ms %10.2f Mvoxels/s %8llu handoffs\n", name, (unsigned long long)voxels,
+           timing.getAccumulatedMilliSeconds(), voxels / timing.getAccumulatedSeconds() / 1e6, (unsigned long long)stats.handoffs);
+}
+
+int main(int argc, char** argv) {
+    LightWorld world;
+    vvox::VoxelLightEngine engine(CHUNK_WIDTH, 15);
+    vcore::ThreadPool<WorkerData> pool;
+    // hardware_concurrency() may report 0 when it cannot tell
+    ui32 numWorkers = std::thread::hardware_concurrency();
+    numWorkers = numWorkers > 1 ? numWorkers - 1 : 1;
+    pool.init(numWorkers, vcore::ThreadPoolScheduler::WORK_STEALING);
+
+    measure("full light, serial", engine, [&] (vorb::AccumulationSamplerContext& timing) {
+        world.seed(engine);
+        VORB_SAMPLE_SCOPE(timing);
+        engine.update();
+    });
+    measure("full light, thread pool", engine, [&] (vorb::AccumulationSamplerContext& timing) {
+        world.seed(engine);
+        VORB_SAMPLE_SCOPE(timing);
+        engine.update(&pool);
+    });
+    measure("edit batches, serial", engine, [&] (vorb::AccumulationSamplerContext& timing) {
+        for (ui32 i = 0; i < 20; i++) {
+            world.edit(engine, i);
+            VORB_SAMPLE_SCOPE(timing);
+            engine.update();
+        }
+    });
+    measure("edit batches, thread pool", engine, [&] (vorb::AccumulationSamplerContext& timing) {
+        for (ui32 i = 20; i < 40; i++) {
+            world.edit(engine, i);
+            VORB_SAMPLE_SCOPE(timing);
+            engine.update(&pool);
+        }
+    });
+
+    pool.destroy();
+    return 0;
+}
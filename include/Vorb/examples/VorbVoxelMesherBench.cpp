@@ -0,0 +1,71 @@
+#include <Vorb/stdafx.h>
+#include <Vorb/voxel/VoxelMesherCulled.h>
+#include <Vorb/ScopedTiming.hpp>
+
+#define CHUNK_WIDTH 32
+#define PADDED_WIDTH (CHUNK_WIDTH + 2)
+#define ITERATIONS 200
+
+/// Solid blocks occlude everything, air occludes nothing
+class CountingMesher {
+public:
+    vvox::meshalg::VoxelFaces occludes(const ui16& v1, const ui16& v2, const vvox::Axis& axis) const {
+        vvox::meshalg::VoxelFaces faces;
+        faces.block1Face = v1 != 0 && v2 == 0;
+        faces.block2Face = v2 != 0 && v1 == 0;
+        return faces;
+    }
+    bool isOpaque(const ui16& v) const {
+        return v != 0;
+    }
+    void result(const vvox::meshalg::VoxelQuad& quad) {
+        quads++;
+        area += quad.size.x * quad.size.y;
+    }
+
+    size_t quads = 0; ///< Emitted quads
+    size_t area = 0; ///< Emitted voxel faces
+};
+
+/// Rolling hills of stone under a layer of dirt, padded by one voxel on every side
+void buildTerrain(std::vector<ui16>& data) {
+    data.assign(PADDED_WIDTH * PADDED_WIDTH * PADDED_WIDTH, 0);
+    for (ui32 z = 0; z < PADDED_WIDTH; z++) {
+        for (ui32 x = 0; x < PADDED_WIDTH; x++) {
+            ui32 height = 12 + (ui32)(6.0 * sin(x * 0.3) * cos(z * 0.2) + 4.0 * sin((x + z) * 0.11));
+            for (ui32 y = 0; y < height && y < PADDED_WIDTH; y++) {
+                data[y * PADDED_WIDTH * PADDED_WIDTH + z * PADDED_WIDTH + x] = y + 3 < height ? 1 : 2;
+            }
+        }
+    }
+}
+
+template<typename F>
+void measure(const char* name, F mesh) {
+    CountingMesher api;
+    vorb::AccumulationSamplerContext timing;
+    for (ui32 i = 0; i < ITERATIONS; i++) {
+        api = CountingMesher();
+        VORB_SAMPLE_SCOPE(timing);
+        mesh(&api);
+    }
+    printf("%-20s %10zu quads %10zu faces %12.3f us/chunk\n", name, api.quads, api.area,
+           timing.getAccumulatedMilliSeconds() * 1000.0 / ITERATIONS);
+}
+
+int main(int argc, char** argv) {
+    std::vector<ui16> data;
+    buildTerrain(data);
+    ui32v3 size(PADDED_WIDTH);
+
+    measure("createCulled", [&] (CountingMesher* api) {
+        vvox::meshalg::createCulled(data.data(), size, api);
+    });
+    measure("createCulledBitmask", [&] (CountingMesher* api) {
+        vvox::meshalg::createCulledBitmask(data.data(), size, api);
+    });
+    measure("createGreedy", [&] (CountingMesher* api) {
+        vvox::meshalg::createGreedy(data.data(), size, api);
+    });
+    return 0;
+}
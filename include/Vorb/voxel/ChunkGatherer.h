@@ -0,0 +1,169 @@
+//
+// ChunkGatherer.h
+// Vorb Engine
+//
+// Created by agent on 17 Oct 2026
+// Copyright 2014 Regrowth Studios
+// All Rights Reserved
+//
+
+/*! \file ChunkGatherer.h
+ * @brief Assembles padded voxel blocks from compressed neighbouring chunks.
+ */
+
+#pragma once
+
+#ifndef Vorb_ChunkGatherer_h__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_ChunkGatherer_h__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include <stdexcept>
+
+#include "types.h"
+#endif // !VORB_USING_PCH
+
+#include "../FixedSizeArrayRecycler.hpp"
+#include "IntervalTree.h"
+
+namespace vorb {
+    namespace voxel {
+        /*! @brief Builds the padded blocks that mesh algorithms expect.
+         *
+         * A padded block holds a chunk plus a border of `padding` voxels taken from the
+         * neighbouring chunks, and is laid out Y-Z-X like createCulled expects. Voxels are copied
+         * straight out of the compressed trees: only the slabs that land in the border are
+         * visited, one row at a time. Blocks come from a shared pool, and gather() only reads
+         * the trees, so one gatherer may be used by every ThreadPool worker at once as long as
+         * nobody writes to the trees meanwhile.
+         *
+         * @tparam T: Voxel data type
+         * @tparam Tree: Compressed chunk type
+         */
+        template<typename T, typename Tree = IntervalTree<T> >
+        class ChunkGatherer {
+        public:
+            static const size_t NEIGHBORHOOD_SIZE = 27; ///< The chunk and all of its neighbours
+
+            /*! @param width: Width of a chunk in voxels
+             * @param padding: Border width taken from each neighbour, at most width
+             * @param maxPooledBlocks: Number of free blocks kept for reuse
+             */
+            ChunkGatherer(ui32 width, ui32 padding = 1, size_t maxPooledBlocks = 64) :
+                m_width(width),
+                m_padding(padding),
+                m_paddedWidth(width + 2 * padding),
+                m_blockSize(m_paddedWidth * m_paddedWidth * m_paddedWidth),
+                m_blocks(std::vector<size_t>(1, m_blockSize), maxPooledBlocks * m_blockSize * sizeof(T)) {
+                if (width == 0 || padding > width) throw std::runtime_error("Chunks need a width, and padding can not exceed it");
+            }
+
+            /*! @brief Slot of a neighbour in the array passed to gather().
+             *
+             * @param offset: Chunk offset, every component in [-1, 1]
+             */
+            static size_t neighborIndex(const i32v3& offset) {
+                return (offset.y + 1) * 9 + (offset.z + 1) * 3 + (offset.x + 1);
+            }
+
+            /*! @brief Assembles a padded block into a pooled buffer.
+             *
+             * @param neighbors: Chunks ordered by neighborIndex(). The center must be set. Missing
+             * neighbours are filled with outside; pass null for edges and corners to skip them.
+             * @param outside: Value for voxels of missing neighbours
+             * @return The padded block, which should be given back with recycle()
+             */
+            CALLEE_DELETE T* gather(const Tree* const* neighbors, const T& outside = T()) {
+                T* block = m_blocks.create(m_blockSize);
+                gather(neighbors, block, outside);
+                return block;
+            }
+            /*! @brief Assembles a padded block into a caller buffer.
+             *
+             * @param dst: Buffer of getBlockSize() voxels
+             */
+            void gather(const Tree* const* neighbors, OUT T* dst, const T& outside = T()) const {
+                for (i32 dy = -1; dy <= 1; dy++) {
+                    for (i32 dz = -1; dz <= 1; dz++) {
+                        for (i32 dx = -1; dx <= 1; dx++) {
+                            i32v3 offset(dx, dy, dz);
+                            gatherCell(neighbors[neighborIndex(offset)], offset, dst, outside);
+                        }
+                    }
+                }
+            }
+
+            /*! @brief Gives a block from gather() back to the pool.
+             */
+            void recycle(T* block) {
+                m_blocks.recycle(block, m_blockSize);
+            }
+
+            /// Getters
+            const ui32& getWidth() const { return m_width; }
+            const ui32& getPadding() const { return m_padding; }
+            const ui32& getPaddedWidth() const { return m_paddedWidth; }
+            const size_t& getBlockSize() const { return m_blockSize; }
+        private:
+            VORB_NON_COPYABLE(ChunkGatherer);
+
+            /*! @brief Copies the part of one neighbour that lands in the block.
+             *
+             * @param offset: Position of the neighbour relative to the center chunk
+             */
+            void gatherCell(const Tree* tree, const i32v3& offset, OUT T* dst, const T& outside) const {
+                // Source box inside the neighbour and where it goes in the block
+                ui32v3 srcMin, srcMax, dstMin;
+                for (i32 i = 0; i < 3; i++) {
+                    switch (offset[i]) {
+                    case -1:
+                        srcMin[i] = m_width - m_padding;
+                        srcMax[i] = m_width;
+                        dstMin[i] = 0;
+                        break;
+                    case 0:
+                        srcMin[i] = 0;
+                        srcMax[i] = m_width;
+                        dstMin[i] = m_padding;
+                        break;
+                    default:
+                        srcMin[i] = 0;
+                        srcMax[i] = m_padding;
+                        dstMin[i] = m_padding + m_width;
+                        break;
+                    }
+                }
+
+                size_t rowLength = srcMax.x - srcMin.x;
+                for (ui32 y = srcMin.y; y < srcMax.y; y++) {
+                    for (ui32 z = srcMin.z; z < srcMax.z; z++) {
+                        T* row = dst + ((dstMin.y + y - srcMin.y) * m_paddedWidth + dstMin.z + z - srcMin.z) * m_paddedWidth + dstMin.x;
+                        if (!tree || tree->size() == 0) {
+                            impl::fillRun(row, rowLength, outside);
+                            continue;
+                        }
+
+                        // Copy the row run by run
+                        size_t begin = ((size_t)y * m_width + z) * m_width + srcMin.x;
+                        size_t end = begin + rowLength;
+                        tree->forEachInterval(begin, end, [&] (const typename Tree::Node& node) {
+                            size_t s = std::max(begin, (size_t)node.getStart());
+                            size_t e = std::min(end, (size_t)node.getStart() + node.length);
+                            impl::fillRun(row + (s - begin), e - s, node.data);
+                        });
+                    }
+                }
+            }
+
+            ui32 m_width; ///< Chunk width
+            ui32 m_padding; ///< Border width
+            ui32 m_paddedWidth; ///< Block width
+            size_t m_blockSize; ///< Voxels per block
+            vcore::SizeClassArrayRecycler<T> m_blocks; ///< Pool of blocks
+        };
+    }
+}
+namespace vvox = vorb::voxel;
+
+#endif // !Vorb_ChunkGatherer_h__
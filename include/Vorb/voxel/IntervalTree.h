@@ -21,60 +21,153 @@
 //! @endcond
 
 #ifndef VORB_USING_PCH
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
 #include "types.h"
 #endif // !VORB_USING_PCH
 
 #pragma once
 #include <map>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VORB_INTERVAL_TREE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace vorb {
+    namespace voxel {
+        namespace impl {
+            /*! @brief Writes a run of identical values.
+             */
+            template<typename T>
+            inline void fillRun(T* dst, size_t length, const T& value) {
+                std::fill_n(dst, length, value);
+            }
+            inline void fillRun(ui8* dst, size_t length, const ui8& value) {
+                memset(dst, value, length);
+            }
+            inline void fillRun(ui16* dst, size_t length, const ui16& value) {
+#ifdef VORB_INTERVAL_TREE_SSE2
+                // Runs are usually long, so write 16 voxels per iteration
+                __m128i v = _mm_set1_epi16((short)value);
+                size_t i = 0;
+                for (; i + 16 <= length; i += 16) {
+                    _mm_storeu_si128((__m128i*)(dst + i), v);
+                    _mm_storeu_si128((__m128i*)(dst + i + 8), v);
+                }
+                if (i + 8 <= length) {
+                    _mm_storeu_si128((__m128i*)(dst + i), v);
+                    i += 8;
+                }
+                for (; i < length; i++) dst[i] = value;
+#else
+                std::fill_n(dst, length, value);
+#endif
+            }
+
+            /*! @brief Counts how many leading elements equal value.
+             */
+            template<typename T>
+            inline size_t runLength(const T* src, size_t size, const T& value) {
+                size_t i = 0;
+                while (i < size && src[i] == value) i++;
+                return i;
+            }
+#ifdef VORB_INTERVAL_TREE_SSE2
+            /*! @brief Index of the first clear bit of a 16-bit comparison mask.
+             */
+            inline size_t firstMismatch(int mask) {
+                size_t i = 0;
+                while (mask & 1) {
+                    mask >>= 1;
+                    i++;
+                }
+                return i;
+            }
+            inline size_t runLength(const ui16* src, size_t size, const ui16& value) {
+                // Compare 8 voxels at a time until one differs
+                __m128i v = _mm_set1_epi16((short)value);
+                size_t i = 0;
+                for (; i + 8 <= size; i += 8) {
+                    int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)(src + i)), v));
+                    if (mask != 0xFFFF) return i + firstMismatch(mask) / 2;
+                }
+                while (i < size && src[i] == value) i++;
+                return i;
+            }
+            inline size_t runLength(const ui8* src, size_t size, const ui8& value) {
+                __m128i v = _mm_set1_epi8((char)value);
+                size_t i = 0;
+                for (; i + 16 <= size; i += 16) {
+                    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(src + i)), v));
+                    if (mask != 0xFFFF) return i + firstMismatch(mask);
+                }
+                while (i < size && src[i] == value) i++;
+                return i;
+            }
+#endif
+        }
+    }
+}
+
 // Implementation of a specialized interval tree based on a red-black tree
 // Red black tree: http://en.wikipedia.org/wiki/Red%E2%80%93black_tree
 
-// NOTE: Currently only works for lengths 32768 and below
-// TODO(Ben): More templatey
+// Index is the unsigned type of starts and lengths. Its top bit stores the node color,
+// so Extent may be at most half its range. The defaults fit a 32^3 chunk; use
+// ui32 for larger extents such as 64^3 chunks or region columns.
 // TODO(Ben): Recombination
 // TODO(Ben): Refactor
-template <typename T>
+template <typename T, typename Index = ui16, size_t Extent = 32768>
 class IntervalTree {
 public:
+    static_assert(std::is_unsigned<Index>::value, "IntervalTree index must be unsigned");
+    static_assert(Extent <= ((size_t)1 << (sizeof(Index) * 8 - 1)), "Extent does not fit in the index");
 
-#define COLOR_BIT 0x8000
-#define START_MASK 0x7FFF
+    /// Signed type of node references, -1 means none
+    typedef typename std::make_signed<Index>::type NodeIndex;
+
+    static const Index COLOR_BIT = (Index)((Index)1 << (sizeof(Index) * 8 - 1));
+    static const Index START_MASK = (Index)(COLOR_BIT - 1);
+    static const size_t EXTENT = Extent;
 
     // Lightweight node for initialization
     class LNode {
     public:
         LNode() {}
-        LNode(ui16 Start, ui16 Length, T Data) : start(Start), length(Length), data(Data) {}
-        void set(ui16 Start, ui16 Length, T Data) {
+        LNode(Index Start, Index Length, T Data) : start(Start), length(Length), data(Data) {}
+        void set(Index Start, Index Length, T Data) {
             start = Start;
             length = Length;
             data = Data;
         }
-        ui16 start;
-        ui16 length;
+        Index start;
+        Index length;
         T data;
     };
 
     class Node {
     public:
         Node() : left(-1), right(-1), parent(-2) {}
-        Node(T Data, ui16 start, ui16 Length) : data(Data), m_start(start | COLOR_BIT), length(Length), left(-1), right(-1), parent(-1) {}
+        Node(T Data, Index start, Index Length) : data(Data), m_start(start | COLOR_BIT), length(Length), left(-1), right(-1), parent(-1) {}
 
         inline void incrementStart() { ++m_start; }
         inline void decrementStart() { --m_start; }
-        inline ui16 getStart() const { return m_start & START_MASK; }
-        inline void setStart(ui16 Start) { m_start = (m_start & COLOR_BIT) | Start; }
+        inline Index getStart() const { return m_start & START_MASK; }
+        inline void setStart(Index Start) { m_start = (m_start & COLOR_BIT) | Start; }
         inline void paintRed() { m_start |= COLOR_BIT; }
         inline void paintBlack() { m_start &= START_MASK; }
         inline bool isRed() const { return (m_start & COLOR_BIT) != 0; }
 
-        ui16 length;
-        i16 left;
-        i16 right;
-        i16 parent;
+        Index length;
+        NodeIndex left;
+        NodeIndex right;
+        NodeIndex parent;
     private:
-        ui16 m_start; //also stores color
+        Index m_start; //also stores color
     public:
         T data;
     };
@@ -115,16 +208,26 @@ public:
     void initSingle(T data, size_t length);
     void initFromSortedArray(const std::vector <LNode>& data);
     void initFromSortedArray(LNode data[], size_t size);
+    /*! @brief Compresses a flat array straight into the tree.
+     *
+     * Runs are detected with SIMD comparisons for ui8 and ui16 and written directly
+     * into the node storage, which keeps its capacity between calls. Recompressing
+     * a chunk of similar complexity therefore does not allocate.
+     *
+     * @param buffer: Flat voxel data
+     * @param size: Number of elements in buffer
+     */
+    void initFromBuffer(const T* buffer, size_t size);
 
     bool checkTreeValidity() const {
-        int tot = 0;
+        size_t tot = 0;
         for (size_t i = 0; i < m_tree.size(); i++) {
-            if (m_tree[i].length > 32768) {
+            if (m_tree[i].length > Extent) {
                 return false;
             }
             tot += m_tree[i].length;
         }
-        if (tot != 32768) {
+        if (tot != Extent) {
             return false;
         }
 
@@ -161,11 +264,56 @@ public:
 
     const T& getData(size_t index) const;
     //Get the enclosing interval for a given point
-    i16 getInterval(size_t index) const;
+    NodeIndex getInterval(size_t index) const;
 
     Node* insert(size_t index, T data);
 
-    void uncompressIntoBuffer(T* buffer);
+    /*! @brief Replaces several ranges at once.
+     *
+     * Rebuilds the tree in a single in-order pass, which is much cheaper than
+     * calling insert() for every voxel once there is more than a handful of edits.
+     * Edits are clipped to the current extent, so they cannot grow the tree and
+     * do nothing on an empty tree; initialize it with initSingle() first.
+     *
+     * @param edits: Ranges to write, sorted by start and not overlapping
+     * @param count: Number of edits
+     */
+    void insertSorted(const LNode* edits, size_t count);
+    void insertSorted(const std::vector<LNode>& edits) { insertSorted(edits.data(), edits.size()); }
+
+    /*! @brief Sets every voxel of [start, start + length) to data.
+     *
+     * Clipped to the current extent like insertSorted(), so it does nothing on an empty tree.
+     */
+    void fill(size_t start, size_t length, T data) {
+        LNode edit((Index)start, (Index)length, data);
+        insertSorted(&edit, 1);
+    }
+
+    /*! @brief Expands the tree into a flat array.
+     *
+     * Walks the nodes in order without recursion and writes each run as a block.
+     *
+     * @param buffer: Destination with room for the whole extent
+     */
+    void uncompressIntoBuffer(T* buffer) const;
+
+    /*! @brief Calls f(node) for every node in ascending order of start.
+     */
+    template<typename F>
+    void forEachInterval(F f) const {
+        if (m_root == -1) return;
+        i32 i = m_root;
+        while (m_tree[i].left != -1) i = m_tree[i].left;
+        for (; i != -1; i = nextInterval(i)) f(m_tree[i]);
+    }
+    /*! @brief Calls f(node) for every node overlapping [begin, end), in ascending order of start.
+     */
+    template<typename F>
+    void forEachInterval(size_t begin, size_t end, F f) const {
+        if (m_root == -1 || begin >= end) return;
+        for (i32 i = getInterval(begin); i != -1 && m_tree[i].getStart() < end; i = nextInterval(i)) f(m_tree[i]);
+    }
 
     iterator begin() { 
         if (m_root == -1) return iterator(nullptr, nullptr);
@@ -183,7 +331,39 @@ public:
     inline int size() const { return m_tree.size(); }
 
 private:
-    void uncompressTraversal(int index, int& bufferIndex, T* buffer);
+    /*! @brief In-order successor of a node, found through parent links.
+     *
+     * @return Index of the next node, or -1 after the last one
+     */
+    i32 nextInterval(i32 i) const {
+        if (m_tree[i].right != -1) {
+            // Leftmost node of the right subtree
+            i = m_tree[i].right;
+            while (m_tree[i].left != -1) i = m_tree[i].left;
+            return i;
+        }
+        // Climb until we come up from a left child
+        i32 child = i;
+        i = m_tree[i].parent;
+        while (i != -1 && m_tree[i].right == child) {
+            child = i;
+            i = m_tree[i].parent;
+        }
+        return i;
+    }
+    /*! @brief Replaces the tree with the runs in m_runs.
+     */
+    void buildFromRuns();
+    /*! @brief Appends a run to m_merged, joining it with the previous one when possible.
+     */
+    void appendRun(size_t start, size_t length, const T& data) {
+        if (length == 0) return;
+        if (m_merged.size() && m_merged.back().data == data) {
+            m_merged.back().length += (Index)length;
+        } else {
+            m_merged.emplace_back((Index)start, (Index)length, data);
+        }
+    }
 
     int arrayToRedBlackTree(int i, int j, int parent, bool isBlack) {
         if (i > j) return -1;
@@ -228,16 +408,25 @@ private:
 
     class NodeToAdd {
     public:
-        NodeToAdd(i16 Parent, ui16 Length, T Data) : start(Parent), length(Length), data(Data) {}
-        i16 start;
-        ui16 length;
+        NodeToAdd(Index Start, Index Length, T Data) : start(Start), length(Length), data(Data) {}
+        Index start;
+        Index length;
         T data;
     };
 
     std::vector <NodeToAdd> m_nodesToAdd;
-    std::vector <ui16> m_nodesToRemove;
+    std::vector <Index> m_nodesToRemove;
+    std::vector <LNode> m_runs; ///< Scratch for bulk operations, keeps its capacity
+    std::vector <LNode> m_merged; ///< Scratch for bulk operations, keeps its capacity
 };
 
 #include "IntervalTree.inl"
 
 #endif // !Vorb_IntervalTree_h__
+
+/*! \example "IntervalTree Bulk Operations Benchmark"
+ *
+ * Compares per-voxel insertion, node-by-node expansion and recompression through
+ * a list of runs against the bulk paths.
+ * \include VorbIntervalTreeBench.cpp
+ */
@@ -1,14 +1,14 @@
 #pragma once
 
-template <typename T>
-inline void IntervalTree<typename T>::initSingle(T data, size_t length) {
+template <typename T, typename Index, size_t Extent>
+inline void IntervalTree<T, Index, Extent>::initSingle(T data, size_t length) {
     m_root = 0;
     m_tree.emplace_back(data, 0, length);
     m_tree[0].paintBlack();
 }
 
-template <typename T>
-void IntervalTree<typename T>::initFromSortedArray(const std::vector <LNode>& data) {
+template <typename T, typename Index, size_t Extent>
+void IntervalTree<T, Index, Extent>::initFromSortedArray(const std::vector <LNode>& data) {
     m_tree.resize(data.size());
     for (size_t i = 0; i < m_tree.size(); i++) {
         m_tree[i].setStart(data[i].start);
@@ -18,8 +18,8 @@ void IntervalTree<typename T>::initFromSortedArray(const std::vector <LNode>& da
     m_root = arrayToRedBlackTree(0, data.size() - 1, -1, true);
 }
 
-template <typename T>
-inline void IntervalTree<typename T>::initFromSortedArray(LNode data[], size_t size) {
+template <typename T, typename Index, size_t Extent>
+inline void IntervalTree<T, Index, Extent>::initFromSortedArray(LNode data[], size_t size) {
     m_tree.resize(size);
     for (size_t i = 0; i < size; i++) {
         m_tree[i].setStart(data[i].start);
@@ -29,22 +29,35 @@ inline void IntervalTree<typename T>::initFromSortedArray(LNode data[], size_t s
     m_root = arrayToRedBlackTree(0, size - 1, -1, true);
 }
 
-template <typename T>
-inline void IntervalTree<typename T>::clear() {
+template <typename T, typename Index, size_t Extent>
+void IntervalTree<T, Index, Extent>::initFromBuffer(const T* buffer, size_t size) {
+    // clear() on the vector keeps the capacity
+    m_tree.clear();
+    size_t start = 0;
+    while (start < size) {
+        size_t length = vorb::voxel::impl::runLength(buffer + start + 1, size - start - 1, buffer[start]) + 1;
+        m_tree.emplace_back(buffer[start], (Index)start, (Index)length);
+        start += length;
+    }
+    m_root = arrayToRedBlackTree(0, (int)m_tree.size() - 1, -1, true);
+}
+
+template <typename T, typename Index, size_t Extent>
+inline void IntervalTree<T, Index, Extent>::clear() {
     std::vector<Node>().swap(m_tree);
     std::vector<NodeToAdd>().swap(m_nodesToAdd);
-    std::vector<ui16>().swap(m_nodesToRemove);
+    std::vector<Index>().swap(m_nodesToRemove);
     m_root = -1;
 }
 
-template <typename T>
-inline const T& IntervalTree<typename T>::getData(size_t index) const {
+template <typename T, typename Index, size_t Extent>
+inline const T& IntervalTree<T, Index, Extent>::getData(size_t index) const {
     return m_tree[getInterval(index)].data;
 }
 
 //Get the enclosing interval for a given point
-template <typename T>
-i16 IntervalTree<typename T>::getInterval(size_t index) const {
+template <typename T, typename Index, size_t Extent>
+typename IntervalTree<T, Index, Extent>::NodeIndex IntervalTree<T, Index, Extent>::getInterval(size_t index) const {
     i32 interval = m_root;
     while (true) {
 
@@ -67,8 +80,8 @@ i16 IntervalTree<typename T>::getInterval(size_t index) const {
     }
 }
 
-template <typename T>
-bool IntervalTree<typename T>::treeInsert(int index, T data, int &newIndex) {
+template <typename T, typename Index, size_t Extent>
+bool IntervalTree<T, Index, Extent>::treeInsert(int index, T data, int &newIndex) {
     int interval = m_root;
     Node* enclosingInterval = nullptr;
     int enclosingIndex = -1;
@@ -80,7 +93,7 @@ bool IntervalTree<typename T>::treeInsert(int index, T data, int &newIndex) {
             //Check if we are at the leaf
             if (node.left == -1) {
                 //check if we are right before the current node               
-                if (index == node.getStart() - 1) {
+                if (index == (int)node.getStart() - 1) {
 
                     if (enclosingInterval) {
                         --(enclosingInterval->length);
@@ -193,8 +206,8 @@ bool IntervalTree<typename T>::treeInsert(int index, T data, int &newIndex) {
     }
 }
 
-template <typename T>
-inline int IntervalTree<typename T>::getGrandparent(Node* node) {
+template <typename T, typename Index, size_t Extent>
+inline int IntervalTree<T, Index, Extent>::getGrandparent(Node* node) {
     if (node->parent != -1) {
         return m_tree[node->parent].parent;
     } else {
@@ -202,8 +215,8 @@ inline int IntervalTree<typename T>::getGrandparent(Node* node) {
     }
 }
 
-template <typename T>
-inline int IntervalTree<typename T>::getUncle(Node* node, Node** grandParent) {
+template <typename T, typename Index, size_t Extent>
+inline int IntervalTree<T, Index, Extent>::getUncle(Node* node, Node** grandParent) {
     int grandparentIndex = getGrandparent(node);
     if (grandparentIndex == -1) {
         *grandParent = nullptr;
@@ -220,10 +233,10 @@ inline int IntervalTree<typename T>::getUncle(Node* node, Node** grandParent) {
     }
 }
 
-template <typename T>
-inline void IntervalTree<typename T>::rotateParentLeft(int index, Node* grandParent) {
+template <typename T, typename Index, size_t Extent>
+inline void IntervalTree<T, Index, Extent>::rotateParentLeft(int index, Node* grandParent) {
     Node& node = m_tree[index];
-    i16 parentIndex = node.parent;
+    NodeIndex parentIndex = node.parent;
     Node& parent = m_tree[parentIndex];
 
     node.parent = parent.parent;
@@ -238,10 +251,10 @@ inline void IntervalTree<typename T>::rotateParentLeft(int index, Node* grandPar
 
 }
 
-template <typename T>
-inline void IntervalTree<typename T>::rotateParentRight(int index, Node* grandParent) {
+template <typename T, typename Index, size_t Extent>
+inline void IntervalTree<T, Index, Extent>::rotateParentRight(int index, Node* grandParent) {
     Node& node = m_tree[index];
-    i16 parentIndex = node.parent;
+    NodeIndex parentIndex = node.parent;
     Node& parent = m_tree[parentIndex];
 
     node.parent = parent.parent;
@@ -255,13 +268,13 @@ inline void IntervalTree<typename T>::rotateParentRight(int index, Node* grandPa
     node.right = parentIndex;
 }
 
-template <typename T>
-inline void IntervalTree<typename T>::rotateRight(int index) {
+template <typename T, typename Index, size_t Extent>
+inline void IntervalTree<T, Index, Extent>::rotateRight(int index) {
 
     Node& node = m_tree.at(index);
     Node& left = m_tree.at(node.left);
 
-    i16 right = left.right;
+    NodeIndex right = left.right;
     left.right = index;
     left.parent = node.parent;
 
@@ -282,13 +295,13 @@ inline void IntervalTree<typename T>::rotateRight(int index) {
 
 }
 
-template <typename T>
-inline void IntervalTree<typename T>::rotateLeft(int index) {
+template <typename T, typename Index, size_t Extent>
+inline void IntervalTree<T, Index, Extent>::rotateLeft(int index) {
 
     Node& node = m_tree.at(index);
     Node& right = m_tree.at(node.right);
 
-    i16 left = right.left;
+    NodeIndex left = right.left;
     right.left = index;
     right.parent = node.parent;
 
@@ -308,27 +321,68 @@ inline void IntervalTree<typename T>::rotateLeft(int index) {
     }
 }
 
-template <typename T>
-void IntervalTree<typename T>::uncompressTraversal(int index, int& bufferIndex, T* buffer) {
-    if (m_tree[index].left != -1) {
-        uncompressTraversal(m_tree[index].left, bufferIndex, buffer);
-    }
-    for (int i = 0; i < m_tree[index].length; i++) {
-        buffer[bufferIndex++] = m_tree[index].data;
-    }
-    if (m_tree[index].right != -1) {
-        uncompressTraversal(m_tree[index].right, bufferIndex, buffer);
+template <typename T, typename Index, size_t Extent>
+void IntervalTree<T, Index, Extent>::uncompressIntoBuffer(T* buffer) const {
+    size_t bufferIndex = 0;
+    forEachInterval([&] (const Node& node) {
+        vorb::voxel::impl::fillRun(buffer + bufferIndex, node.length, node.data);
+        bufferIndex += node.length;
+    });
+}
+
+template <typename T, typename Index, size_t Extent>
+void IntervalTree<T, Index, Extent>::insertSorted(const LNode* edits, size_t count) {
+    if (count == 0) return;
+
+    // Flatten the current runs
+    m_runs.clear();
+    forEachInterval([&] (const Node& node) {
+        m_runs.emplace_back(node.getStart(), node.length, node.data);
+    });
+    size_t extent = 0;
+    if (m_runs.size()) extent = (size_t)m_runs.back().start + m_runs.back().length;
+
+    // Sweep the edits over the old runs
+    m_merged.clear();
+    size_t r = 0;
+    size_t cursor = 0;
+    auto copyOld = [&] (size_t end) {
+        while (r < m_runs.size() && (size_t)m_runs[r].start + m_runs[r].length <= cursor) r++;
+        for (size_t i = r; i < m_runs.size() && m_runs[i].start < end; i++) {
+            size_t s = std::max(cursor, (size_t)m_runs[i].start);
+            size_t e = std::min(end, (size_t)m_runs[i].start + m_runs[i].length);
+            appendRun(s, e - s, m_runs[i].data);
+        }
+    };
+    for (size_t i = 0; i < count; i++) {
+        size_t start = std::max((size_t)edits[i].start, cursor);
+        size_t end = std::min((size_t)edits[i].start + edits[i].length, extent);
+        if (start >= end) continue;
+        copyOld(start);
+        appendRun(start, end - start, edits[i].data);
+        cursor = end;
     }
+    copyOld(extent);
+
+    m_runs.swap(m_merged);
+    buildFromRuns();
 }
 
-template <typename T>
-void IntervalTree<typename T>::uncompressIntoBuffer(T* buffer) {
-    int bufferIndex = 0;
-    uncompressTraversal(m_root, bufferIndex, buffer);
+template <typename T, typename Index, size_t Extent>
+void IntervalTree<T, Index, Extent>::buildFromRuns() {
+    // resize() keeps the capacity, so steady state rebuilds do not allocate
+    m_tree.resize(m_runs.size());
+    for (size_t i = 0; i < m_runs.size(); i++) {
+        Node& node = m_tree[i];
+        node.setStart(m_runs[i].start);
+        node.length = m_runs[i].length;
+        node.data = m_runs[i].data;
+    }
+    m_root = arrayToRedBlackTree(0, (int)m_runs.size() - 1, -1, true);
 }
 
-template <typename T>
-typename IntervalTree<typename T>::Node* IntervalTree<typename T>::insert(size_t index, T data) {
+template <typename T, typename Index, size_t Extent>
+typename IntervalTree<T, Index, Extent>::Node* IntervalTree<T, Index, Extent>::insert(size_t index, T data) {
 
     int nodeIndex;
     if (!treeInsert(index, data, nodeIndex)) {
@@ -425,14 +479,14 @@ typename IntervalTree<typename T>::Node* IntervalTree<typename T>::insert(size_t
 }
 
 // Iterators
-template <typename T>
-IntervalTree<typename T>::iterator::iterator(pointer ptr, std::vector <Node>* tree) : m_ptr(ptr), m_tree(tree) {
+template <typename T, typename Index, size_t Extent>
+IntervalTree<T, Index, Extent>::iterator::iterator(pointer ptr, std::vector <Node>* tree) : m_ptr(ptr), m_tree(tree) {
     if (m_ptr == nullptr) return;
     while (m_ptr->left != -1) m_ptr = &m_tree->operator[](m_ptr->left);
 }
 
-template <typename T>
-typename IntervalTree<typename T>::iterator::self_type IntervalTree<typename T>::iterator::operator++() {
+template <typename T, typename Index, size_t Extent>
+typename IntervalTree<T, Index, Extent>::iterator::self_type IntervalTree<T, Index, Extent>::iterator::operator++() {
     if (m_ptr == nullptr) throw std::runtime_error("Attempted to increment iterator at end.");
     self_type i = *this;
     pointer r = m_ptr;
@@ -458,14 +512,14 @@ typename IntervalTree<typename T>::iterator::self_type IntervalTree<typename T>:
     return i;
 }
 
-template <typename T>
-IntervalTree<typename T>::const_iterator::const_iterator(pointer ptr, std::vector <Node>* tree) : m_ptr(ptr), m_tree(tree) {
+template <typename T, typename Index, size_t Extent>
+IntervalTree<T, Index, Extent>::const_iterator::const_iterator(pointer ptr, std::vector <Node>* tree) : m_ptr(ptr), m_tree(tree) {
     if (m_ptr == nullptr) return;
     while (m_ptr->left != -1) m_ptr = &m_tree->operator[](m_ptr->left);
 }
 
-template <typename T>
-typename IntervalTree<typename T>::const_iterator::self_type IntervalTree<typename T>::const_iterator::operator++() {
+template <typename T, typename Index, size_t Extent>
+typename IntervalTree<T, Index, Extent>::const_iterator::self_type IntervalTree<T, Index, Extent>::const_iterator::operator++() {
     if (m_ptr == nullptr) throw std::runtime_error("Attempted to increment const_iterator at end.");
     self_type i = *this;
     pointer r = m_ptr;
@@ -0,0 +1,357 @@
+//
+// VoxelAtlasPacker.h
+// Vorb Engine
+//
+// Created by agent on 17 Oct 2026
+// Copyright 2014 Regrowth Studios
+// All Rights Reserved
+//
+
+/*! \file VoxelAtlasPacker.h
+ * @brief Packs voxel tile textures of mixed sizes into atlas pages.
+ */
+
+#pragma once
+
+#ifndef Vorb_VoxelAtlasPacker_h__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_VoxelAtlasPacker_h__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "types.h"
+#endif // !VORB_USING_PCH
+
+#include "../BitUtils.h"
+
+namespace vorb {
+    namespace voxel {
+        /*! @brief Occupancy counters of a VoxelAtlasPacker.
+         */
+        struct AtlasPackerStats {
+        public:
+            size_t pages = 0; ///< Allocated pages
+            size_t usedTiles = 0; ///< Tiles covered by mapped textures
+            size_t freeTiles = 0; ///< Tiles not covered by anything
+            size_t holeTiles = 0; ///< Free tiles below the skyline, left behind by removals or skyline gaps
+        };
+
+        /*! @brief Outcome of VoxelAtlasPacker::defragment().
+         */
+        struct AtlasCompactionReport {
+        public:
+            size_t pagesBefore = 0; ///< Pages in use before compaction
+            size_t pagesAfter = 0; ///< Pages in use after compaction
+            std::vector<std::pair<ui32, ui32> > moves; ///< Old and new index of every texture that moved
+        };
+
+        /*! @brief Maps textures into atlas pages, like VoxelTextureStitcher, with fast mixed-size packing.
+         *
+         * Indices follow VoxelTextureStitcher: page * tilesPerPage + row * tilesPerRow + column,
+         * and index 0 is mapped to the null texture on construction. Each page keeps one bit
+         * per tile, a row in one 64-bit word, and a skyline of the highest occupied row per column.
+         * While a page has no holes, boxes go where they leave the skyline lowest. Once textures
+         * have been removed, the bit rows are searched bottom-left for a free rectangle with
+         * shifts and ANDs over whole rows. Pages that cannot hold the area are skipped without
+         * looking at them, so mapping thousands of textures stays close to linear.
+         */
+        class VoxelAtlasPacker {
+        public:
+            /*! @param tilesPerRow: Width and height of a page in tiles, at most 64
+             */
+            VoxelAtlasPacker(ui32 tilesPerRow = 16u) :
+                m_tilesPerRow(tilesPerRow),
+                m_tilesPerPage(tilesPerRow * tilesPerRow) {
+                if (tilesPerRow == 0 || tilesPerRow > 64) throw std::runtime_error("Tiles per row must be in [1, 64]");
+                m_rowMask = tilesPerRow == 64 ? ~0ull : (1ull << tilesPerRow) - 1;
+                mapSingle();
+            }
+
+            /// Maps a single block texture to the atlases
+            /// @return The index of the texture start into the atlas array.
+            ui32 mapSingle() {
+                return mapBox(1, 1);
+            }
+            /// Maps a large box texture to the atlases
+            /// @param width: The width of the box
+            /// @param height: The height of the box
+            /// @return The index of the texture start into the atlas array.
+            ui32 mapBox(ui32 width, ui32 height) {
+                if (width == 0 || height == 0 || width > m_tilesPerRow || height > m_tilesPerRow) {
+                    throw std::runtime_error("Box does not fit on an atlas page");
+                }
+                ui32 index = placeBox(width, height);
+                m_allocations[index] = Allocation(width, height, 0);
+                return index;
+            }
+            /// Maps a contiguous array of single textures to the atlases
+            /// @param numTiles: The number of tiles to map, at most a page
+            /// @return The index of the texture start into the atlas array.
+            ui32 mapContiguous(ui32 numTiles) {
+                if (numTiles == 0 || numTiles > m_tilesPerPage) throw std::runtime_error("Contiguous run does not fit on an atlas page");
+                ui32 index = placeContiguous(numTiles);
+                m_allocations[index] = Allocation(0, 0, numTiles);
+                return index;
+            }
+
+            /*! @brief Frees the tiles of a mapped texture.
+             *
+             * @param index: Value returned by one of the map functions
+             */
+            void unmap(ui32 index) {
+                auto it = m_allocations.find(index);
+                if (it == m_allocations.end()) return;
+                Page& page = m_pages[index / m_tilesPerPage];
+                forEachRow(index, it->second, [&] (ui32 y, ui64 bits) {
+                    page.rows[y] &= ~bits;
+                });
+                page.freeTiles += it->second.area();
+                page.hasHoles = true;
+                updateSkyline(page);
+                m_allocations.erase(it);
+                m_firstFreePage = std::min(m_firstFreePage, (size_t)(index / m_tilesPerPage));
+            }
+
+            /*! @brief Repacks every texture as tightly as possible.
+             *
+             * Textures are placed again from scratch, tallest first, and trailing empty pages
+             * are released. The null texture stays at index 0. Textures listed in the report
+             * must be copied to their new index and every stored index remapped.
+             *
+             * @return Pages before and after, and the moves that were made
+             */
+            AtlasCompactionReport defragment() {
+                AtlasCompactionReport report;
+                report.pagesBefore = m_pages.size();
+
+                std::vector<std::pair<ui32, Allocation> > live(m_allocations.begin(), m_allocations.end());
+                std::sort(live.begin(), live.end(), [] (const std::pair<ui32, Allocation>& a, const std::pair<ui32, Allocation>& b) {
+                    // Keep the null texture first, then tall boxes, wide boxes and long runs
+                    if ((a.first == 0) != (b.first == 0)) return a.first == 0;
+                    if (a.second.height != b.second.height) return a.second.height > b.second.height;
+                    if (a.second.width != b.second.width) return a.second.width > b.second.width;
+                    if (a.second.count != b.second.count) return a.second.count > b.second.count;
+                    return a.first < b.first;
+                });
+
+                m_pages.clear();
+                m_allocations.clear();
+                m_firstFreePage = 0;
+                for (auto& entry : live) {
+                    const Allocation& a = entry.second;
+                    ui32 index = a.count ? placeContiguous(a.count) : placeBox(a.width, a.height);
+                    m_allocations[index] = a;
+                    if (index != entry.first) report.moves.emplace_back(entry.first, index);
+                }
+
+                report.pagesAfter = m_pages.size();
+                return report;
+            }
+
+            /*! @brief Frees all pages and mappings, including the null texture.
+             */
+            void dispose() {
+                std::vector<Page>().swap(m_pages);
+                m_allocations.clear();
+                m_firstFreePage = 0;
+            }
+
+            /// @return Occupancy of all pages
+            AtlasPackerStats getStats() const {
+                AtlasPackerStats stats;
+                stats.pages = m_pages.size();
+                for (auto& page : m_pages) {
+                    stats.freeTiles += page.freeTiles;
+                    for (ui32 x = 0; x < m_tilesPerRow; x++) {
+                        for (ui32 y = 0; y < page.skyline[x]; y++) {
+                            if (((page.rows[y] >> x) & 1) == 0) stats.holeTiles++;
+                        }
+                    }
+                }
+                stats.usedTiles = stats.pages * m_tilesPerPage - stats.freeTiles;
+                return stats;
+            }
+
+            /*! @brief Retrieve the number of pages currently allocated by the mapper
+            *
+            * @return Number of allocated pages
+            */
+            size_t getNumPages() const {
+                return m_pages.size();
+            }
+            const ui32& getTilesPerRow() const { return m_tilesPerRow; }
+            const ui32& getTilesPerPage() const { return m_tilesPerPage; }
+        private:
+            VORB_NON_COPYABLE(VoxelAtlasPacker);
+
+            /// Size of a mapped texture, either a box or a contiguous run
+            struct Allocation {
+            public:
+                Allocation() {}
+                Allocation(ui32 w, ui32 h, ui32 c) : width(w), height(h), count(c) {}
+
+                ui32 area() const { return count ? count : width * height; }
+
+                ui32 width = 0; ///< Box width in tiles
+                ui32 height = 0; ///< Box height in tiles
+                ui32 count = 0; ///< Run length, or 0 for a box
+            };
+
+            /// Tile occupancy of one atlas page
+            struct Page {
+            public:
+                std::vector<ui64> rows; ///< Bit x of row y is set when the tile is taken
+                std::vector<ui32> skyline; ///< One past the highest taken row of each column
+                ui32 freeTiles; ///< Number of clear bits
+                bool hasHoles = false; ///< True when free tiles may lie below the skyline
+            };
+
+            void addPage() {
+                m_pages.emplace_back();
+                Page& page = m_pages.back();
+                page.rows.assign(m_tilesPerRow, 0);
+                page.skyline.assign(m_tilesPerRow, 0);
+                page.freeTiles = m_tilesPerPage;
+            }
+
+            /// Calls f(row, bits) for every row an allocation covers
+            template<typename F>
+            void forEachRow(ui32 index, const Allocation& a, F f) const {
+                ui32 local = index % m_tilesPerPage;
+                ui32 x = local % m_tilesPerRow;
+                ui32 y = local / m_tilesPerRow;
+                if (a.count == 0) {
+                    ui64 bits = (a.width == 64 ? ~0ull : (1ull << a.width) - 1) << x;
+                    for (ui32 r = 0; r < a.height; r++) f(y + r, bits);
+                    return;
+                }
+                // Runs wrap from the end of one row to the start of the next
+                ui32 remaining = a.count;
+                while (remaining > 0) {
+                    ui32 n = std::min(remaining, m_tilesPerRow - x);
+                    f(y, (n == 64 ? ~0ull : (1ull << n) - 1) << x);
+                    remaining -= n;
+                    x = 0;
+                    y++;
+                }
+            }
+
+            /// Marks tiles as taken and raises the skyline
+            void take(ui32 pageIndex, ui32 index, const Allocation& a) {
+                Page& page = m_pages[pageIndex];
+                forEachRow(index, a, [&] (ui32 y, ui64 bits) {
+                    page.rows[y] |= bits;
+                    for (ui32 x = 0; x < m_tilesPerRow; x++) {
+                        if (((bits >> x) & 1) && page.skyline[x] < y + 1) {
+                            // Anything skipped under the new top is a hole
+                            if (page.skyline[x] < y) page.hasHoles = true;
+                            page.skyline[x] = y + 1;
+                        }
+                    }
+                });
+                page.freeTiles -= a.area();
+                while (m_firstFreePage < m_pages.size() && m_pages[m_firstFreePage].freeTiles == 0) m_firstFreePage++;
+            }
+
+            void updateSkyline(Page& page) {
+                for (ui32 x = 0; x < m_tilesPerRow; x++) {
+                    ui32 h = page.skyline[x];
+                    while (h > 0 && ((page.rows[h - 1] >> x) & 1) == 0) h--;
+                    page.skyline[x] = h;
+                }
+            }
+
+            /// Finds a spot for a box, adding a page if none has room
+            ui32 placeBox(ui32 width, ui32 height) {
+                Allocation a(width, height, 0);
+                for (size_t p = m_firstFreePage;; p++) {
+                    if (p == m_pages.size()) addPage();
+                    Page& page = m_pages[p];
+                    if (page.freeTiles < a.area()) continue;
+
+                    ui32 x, y;
+                    bool found = page.hasHoles ? findBitsetFit(page, width, height, x, y) : findSkylineFit(page, width, height, x, y);
+                    if (found) {
+                        ui32 index = (ui32)p * m_tilesPerPage + y * m_tilesPerRow + x;
+                        take((ui32)p, index, a);
+                        return index;
+                    }
+                }
+            }
+
+            /// Bottom-left position over the skyline, preferring the lowest resulting top
+            bool findSkylineFit(const Page& page, ui32 width, ui32 height, OUT ui32& bestX, OUT ui32& bestY) const {
+                ui32 bestTop = m_tilesPerRow + 1;
+                for (ui32 x = 0; x + width <= m_tilesPerRow; x++) {
+                    ui32 y = 0;
+                    for (ui32 i = 0; i < width; i++) y = std::max(y, page.skyline[x + i]);
+                    if (y + height <= m_tilesPerRow && y + height < bestTop) {
+                        bestTop = y + height;
+                        bestX = x;
+                        bestY = y;
+                    }
+                }
+                return bestTop <= m_tilesPerRow;
+            }
+
+            /// Lowest, then leftmost, free rectangle according to the bit rows
+            bool findBitsetFit(const Page& page, ui32 width, ui32 height, OUT ui32& bestX, OUT ui32& bestY) const {
+                for (ui32 y = 0; y + height <= m_tilesPerRow; y++) {
+                    ui64 fits = m_rowMask;
+                    for (ui32 r = y; r < y + height && fits; r++) {
+                        // Bit x stays set if tiles x to x + width - 1 are all free
+                        ui64 free = ~page.rows[r] & m_rowMask;
+                        ui64 run = free;
+                        for (ui32 k = 1; k < width && run; k++) run &= free >> k;
+                        fits &= run;
+                    }
+                    if (fits) {
+                        bestX = vorb::lowestSetBit(fits);
+                        bestY = y;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            /// Finds a run of consecutive indices, adding a page if none has room
+            ui32 placeContiguous(ui32 count) {
+                Allocation a(0, 0, count);
+                for (size_t p = m_firstFreePage;; p++) {
+                    if (p == m_pages.size()) addPage();
+                    Page& page = m_pages[p];
+                    if (page.freeTiles < count) continue;
+
+                    ui32 run = 0;
+                    for (ui32 i = 0; i < m_tilesPerPage; i++) {
+                        if ((page.rows[i / m_tilesPerRow] >> (i % m_tilesPerRow)) & 1) {
+                            run = 0;
+                            continue;
+                        }
+                        if (++run == count) {
+                            ui32 index = (ui32)p * m_tilesPerPage + i + 1 - count;
+                            take((ui32)p, index, a);
+                            return index;
+                        }
+                    }
+                }
+            }
+
+            std::vector<Page> m_pages; ///< Occupancy of each page
+            std::unordered_map<ui32, Allocation> m_allocations; ///< Mapped textures by index
+            size_t m_firstFreePage = 0; ///< No page before this one has a free tile
+            ui32 m_tilesPerRow; ///< Page width and height in tiles
+            ui32 m_tilesPerPage; ///< Tiles per page
+            ui64 m_rowMask; ///< Bits of a row that belong to the page
+        };
+    }
+}
+namespace vvox = vorb::voxel;
+
+#endif // !Vorb_VoxelAtlasPacker_h__
@@ -0,0 +1,237 @@
+//
+// VoxelLOD.h
+// Vorb Engine
+//
+// Created by agent on 17 Oct 2026
+// Copyright 2014 Regrowth Studios
+// All Rights Reserved
+//
+
+/*! \file VoxelLOD.h
+ * @brief Downsampled voxel volumes and seams for meshing distant chunks.
+ *
+ * A level of detail is made by repeatedly halving a volume, each output voxel voting on
+ * its 2x2x2 source block. Downsampling a padded block from ChunkGatherer whose padding
+ * equals the LOD factor yields a block with a one voxel border of real neighbour data,
+ * which any of the mesh algorithms accepts directly. Quads then come out in LOD voxel
+ * units and are scaled by the factor when rendered.
+ */
+
+#pragma once
+
+#ifndef Vorb_VoxelLOD_h__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_VoxelLOD_h__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include <vector>
+
+#include "types.h"
+#endif // !VORB_USING_PCH
+
+#include "IntervalTree.h"
+#include "VoxelMeshAlg.h"
+
+namespace vorb {
+    namespace voxel {
+        /*! @brief Keeps the value that occurs most often in a block.
+         *
+         * Ties go to the value found first, in Y-Z-X order.
+         */
+        template<typename T>
+        class MajorityVote {
+        public:
+            T operator()(const T (&block)[8]) const {
+                size_t best = 0;
+                ui32 bestCount = 0;
+                for (size_t i = 0; i < 8 && bestCount < 5; i++) {
+                    ui32 count = 0;
+                    for (size_t j = i; j < 8; j++) {
+                        if (block[j] == block[i]) count++;
+                    }
+                    if (count > bestCount) {
+                        best = i;
+                        bestCount = count;
+                    }
+                }
+                return block[best];
+            }
+        };
+
+        /*! @brief Keeps the value with the highest priority in a block.
+         *
+         * Useful to keep thin features such as ore veins or tree trunks alive at a distance.
+         *
+         * @tparam Priority: Callable as ui32 priority(const T&)
+         */
+        template<typename T, typename Priority>
+        class PriorityVote {
+        public:
+            PriorityVote(Priority priority) : m_priority(priority) {
+                // Empty
+            }
+
+            T operator()(const T (&block)[8]) const {
+                size_t best = 0;
+                ui32 bestPriority = m_priority(block[0]);
+                for (size_t i = 1; i < 8; i++) {
+                    ui32 p = m_priority(block[i]);
+                    if (p > bestPriority) {
+                        best = i;
+                        bestPriority = p;
+                    }
+                }
+                return block[best];
+            }
+        private:
+            Priority m_priority;
+        };
+        template<typename T, typename Priority>
+        inline PriorityVote<T, Priority> makePriorityVote(Priority priority) {
+            return PriorityVote<T, Priority>(priority);
+        }
+
+        /*! @brief Halves a volume along every axis.
+         *
+         * @param src: Voxels accessed Y-Z-X
+         * @param size: Sizes of src (XYZ), all even
+         * @param dst: Receives size / 2 voxels, accessed Y-Z-X
+         * @param vote: Callable as T vote(const T (&block)[8])
+         */
+        template<typename T, typename Vote>
+        inline void downsample2x(const T* src, const ui32v3& size, OUT T* dst, const Vote& vote) {
+            size_t l1 = size.x;
+            size_t l2 = l1 * size.z;
+            T block[8];
+            for (ui32 y = 0; y < size.y; y += 2) {
+                for (ui32 z = 0; z < size.z; z += 2) {
+                    const T* row = src + y * l2 + z * l1;
+                    for (ui32 x = 0; x < size.x; x += 2) {
+                        block[0] = row[x];
+                        block[1] = row[x + 1];
+                        block[2] = row[x + l1];
+                        block[3] = row[x + l1 + 1];
+                        block[4] = row[x + l2];
+                        block[5] = row[x + l2 + 1];
+                        block[6] = row[x + l2 + l1];
+                        block[7] = row[x + l2 + l1 + 1];
+                        *dst++ = vote(block);
+                    }
+                }
+            }
+        }
+
+        namespace impl {
+            /// Number of voxels in the intermediate levels of a downsample
+            inline size_t lodScratchSize(const ui32v3& size, ui32 factor) {
+                size_t half = (size_t)(size.x / 2) * (size.y / 2) * (size.z / 2);
+                if (factor <= 2) return 0;
+                return factor == 4 ? half : half + half / 8;
+            }
+
+            template<typename T, typename Vote>
+            inline void downsample(const T* src, ui32v3 size, ui32 factor, OUT T* dst, const Vote& vote, T* levels) {
+                const T* level = src;
+                T* out = factor > 2 ? levels : dst;
+                for (ui32 f = factor; f > 1; f >>= 1) {
+                    if (f == 2) out = dst;
+                    downsample2x(level, size, out, vote);
+                    size /= 2u;
+                    level = out;
+                    out += (size_t)size.x * size.y * size.z;
+                }
+            }
+        }
+
+        /*! @brief Builds a 2x, 4x or 8x level of detail by repeated halving.
+         *
+         * @param src: Voxels accessed Y-Z-X
+         * @param size: Sizes of src (XYZ), all divisible by factor
+         * @param factor: 2, 4 or 8
+         * @param dst: Receives size / factor voxels, accessed Y-Z-X
+         * @param vote: Callable as T vote(const T (&block)[8])
+         * @param scratch: Holds the intermediate levels, reused between calls when given
+         */
+        template<typename T, typename Vote>
+        inline void downsample(const T* src, const ui32v3& size, ui32 factor, OUT T* dst, const Vote& vote, OPT std::vector<T>* scratch = nullptr) {
+            std::vector<T> localScratch;
+            if (!scratch) scratch = &localScratch;
+            scratch->resize(impl::lodScratchSize(size, factor));
+            impl::downsample(src, size, factor, dst, vote, scratch->data());
+        }
+
+        /*! @brief Builds a level of detail straight from a compressed chunk.
+         *
+         * @param tree: Chunk of width^3 voxels
+         * @param scratch: Holds the decompressed chunk and intermediate levels, reused between calls when given
+         */
+        template<typename T, typename Tree, typename Vote>
+        inline void downsample(const Tree& tree, ui32 width, ui32 factor, OUT T* dst, const Vote& vote, OPT std::vector<T>* scratch = nullptr) {
+            std::vector<T> localScratch;
+            if (!scratch) scratch = &localScratch;
+            ui32v3 size(width);
+            size_t volume = (size_t)width * width * width;
+            scratch->resize(volume + impl::lodScratchSize(size, factor));
+            tree.uncompressIntoBuffer(scratch->data());
+            impl::downsample(scratch->data(), size, factor, dst, vote, scratch->data() + volume);
+        }
+
+        namespace meshalg {
+            /*! @brief Emits the boundary faces that normal culling hides, to close cracks between LODs.
+             *
+             * Where a chunk borders one at a different level of detail, the two surfaces no longer
+             * line up and gaps open along the seam. For every opaque voxel on a chosen boundary
+             * layer whose neighbour across the boundary is also opaque, the face towards the
+             * neighbour is emitted. These walls fill the gaps and stay hidden where the surfaces
+             * do meet. Faces where the neighbour is not opaque are already emitted by the culled meshers.
+             *
+             * @tparam API: Type with bool isOpaque(const T&) and result(const VoxelQuad&)
+             * @param data: Padded 3D array of voxel data accessed Y-Z-X
+             * @param size: Sizes of array (XYZ)
+             * @param sides: Bit (1 << Cardinal) set for every side that borders another LOD
+             * @param api: API object
+             */
+            template<typename T, typename API>
+            inline void createSeams(const T* data, const ui32v3& size, ui32 sides, API* api) {
+                if (size.x < 3 || size.y < 3 || size.z < 3) return;
+
+                size_t l1 = size.x;
+                size_t l2 = l1 * size.z;
+                VoxelQuad q;
+                q.size = ui32v2(1, 1);
+                for (ui32 c = 0; c < 6; c++) {
+                    if ((sides & (1 << c)) == 0) continue;
+                    ui32 axis = c >> 1;
+                    bool positive = (c & 1) != 0;
+                    q.direction = (Cardinal)c;
+
+                    // Boundary layer inside the chunk and the padding layer beyond it
+                    ui32v3 pos, other;
+                    ui32 inner = positive ? size[axis] - 2 : 1;
+                    ui32 outer = positive ? size[axis] - 1 : 0;
+                    ui32 a1 = axis == 0 ? 1 : 0;
+                    ui32 a2 = axis == 2 ? 1 : 2;
+                    for (ui32 j = 1; j < size[a2] - 1; j++) {
+                        for (ui32 i = 1; i < size[a1] - 1; i++) {
+                            pos[axis] = inner;
+                            pos[a1] = i;
+                            pos[a2] = j;
+                            other = pos;
+                            other[axis] = outer;
+                            size_t index = pos.y * l2 + pos.z * l1 + pos.x;
+                            if (api->isOpaque(data[index]) && api->isOpaque(data[other.y * l2 + other.z * l1 + other.x])) {
+                                q.voxelPosition = pos;
+                                q.startIndex = (ui32)index;
+                                api->result(q);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+namespace vvox = vorb::voxel;
+
+#endif // !Vorb_VoxelLOD_h__
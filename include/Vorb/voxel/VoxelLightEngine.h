@@ -0,0 +1,543 @@
+//
+// VoxelLightEngine.h
+// Vorb Engine
+//
+// Created by agent on 17 Oct 2026
+// Copyright 2014 Regrowth Studios
+// All Rights Reserved
+//
+
+/*! \file VoxelLightEngine.h
+ * @brief Flood-fill propagation of sunlight and block light through chunks.
+ */
+
+#pragma once
+
+#ifndef Vorb_VoxelLightEngine_h__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_VoxelLightEngine_h__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "types.h"
+#endif // !VORB_USING_PCH
+
+#include "concurrentqueue.h"
+#include "../RingBuffer.hpp"
+#include "../ThreadPool.h"
+#include "VoxCommon.h"
+
+namespace vorb {
+    namespace voxel {
+        /// Kinds of light kept for every voxel
+        enum class LightChannel : ui8 {
+            SUN = 0, ///< Falls from the sky, straight down without losing strength
+            BLOCK = 1 ///< Emitted by blocks, weakens with every step
+        };
+        const size_t NUM_LIGHT_CHANNELS = 2; ///< Number of LightChannel values
+
+        /// Counters of a VoxelLightEngine
+        struct LightEngineStats {
+        public:
+            ui64 voxelsLit = 0; ///< Voxels whose light was raised
+            ui64 voxelsCleared = 0; ///< Voxels whose light was removed
+            ui64 handoffs = 0; ///< Steps that crossed into a neighbouring volume
+            ui64 passes = 0; ///< Times a volume was processed
+        };
+
+        namespace impl {
+            const ui8 LIGHT_SEED = 6; ///< LightNode direction of nodes that did not come from a neighbour
+
+            /// One entry of a propagation queue or inbox
+            struct LightNode {
+            public:
+                ui32 index; ///< Voxel index, Y-Z-X
+                ui8 value; ///< Light carried by the step, 0 for seeds that act on the current light
+                ui8 direction; ///< Cardinal the step travels in, or LIGHT_SEED
+                bool isRemoval; ///< True for cleared seeds and steps to clear
+            };
+        }
+
+        /*! @brief Light of one chunk-sized volume, as seen by a VoxelLightEngine.
+         *
+         * The arrays belong to the caller and hold width^3 voxels, Y-Z-X like the meshers
+         * expect. The engine only writes to a volume from one thread at a time and never reads
+         * a neighbour's arrays while propagating: steps that leave the volume are handed to the
+         * neighbour, which checks them against its own data.
+         */
+        class LightVolume {
+            friend class VoxelLightEngine;
+        public:
+            LightVolume() {
+                for (size_t i = 0; i < NUM_LIGHT_CHANNELS; i++) light[i] = nullptr;
+                for (size_t i = 0; i < 6; i++) neighbors[i] = nullptr;
+            }
+
+            ui8* light[NUM_LIGHT_CHANNELS]; ///< Light per channel, indexed by LightChannel
+            const ui8* opacity = nullptr; ///< Extra light lost entering a voxel, maxLight or more blocks it. Null is all clear.
+            const ui8* emission = nullptr; ///< Block light emitted by each voxel, null if nothing glows
+            LightVolume* neighbors[6]; ///< Adjacent volumes indexed by Cardinal, null at the edge of the world
+        private:
+            VORB_NON_COPYABLE(LightVolume);
+
+            /// @return True if the inbox holds anything
+            bool hasMail() {
+                std::lock_guard<std::mutex> lock(m_lock);
+                for (auto& inbox : m_inbox) {
+                    if (!inbox.empty()) return true;
+                }
+                return false;
+            }
+
+            std::mutex m_lock; ///< Guards m_inbox
+            std::vector<impl::LightNode> m_inbox[NUM_LIGHT_CHANNELS]; ///< Pending work, in the order it was sent
+            std::atomic<bool> m_isScheduled = ATOMIC_VAR_INIT(false); ///< True while queued or being processed
+        };
+
+        /*! @brief Spreads sunlight and block light by breadth-first flood fill.
+         *
+         * Light loses one level per step, plus the opacity of the voxel it enters, except for
+         * sunlight at full strength which falls straight down through clear voxels. Edits are
+         * queued with the seeding functions and resolved together by update(): all removals
+         * of a volume run first, clearing everything that depended on the removed light, then
+         * the light bordering the cleared region floods back in along with any new light. Steps
+         * that cross into a neighbour are batched and handed over once a volume is done.
+         *
+         * update() processes volumes one by one on the calling thread. The ThreadPool overload
+         * runs one task per volume with pending work; a volume is never processed by two tasks
+         * at once, and hand-offs schedule the neighbour if it is not already queued.
+         *
+         * Seeding functions and getStats() must not be called while an update is running.
+         */
+        class VoxelLightEngine {
+        public:
+            /*! @param width: Width of a volume in voxels
+             * @param maxLight: Strongest light level, at most 255
+             */
+            VoxelLightEngine(ui32 width = 32, ui8 maxLight = 15) :
+                m_width(width),
+                m_layer(width * width),
+                m_volume(width * width * width),
+                m_maxLight(maxLight) {
+                if (width == 0 || maxLight == 0) throw std::runtime_error("Light volumes need a width and a maximum light level");
+            }
+            ~VoxelLightEngine() {
+                for (auto& scratch : m_scratch) delete scratch;
+            }
+
+            /*! @brief Lights a voxel, for example when an emitter is placed.
+             *
+             * Emitters must also be set in LightVolume::emission, or removing other light
+             * nearby may wipe out theirs.
+             *
+             * @param index: Voxel index, Y-Z-X
+             * @param value: Light level, ignored if the voxel is already as bright
+             */
+            void addLight(LightVolume* volume, LightChannel channel, ui32 index, ui8 value) {
+                impl::LightNode node = { index, value, impl::LIGHT_SEED, false };
+                post(volume, channel, node);
+            }
+            /*! @brief Removes the light of a voxel and all light that came from it.
+             *
+             * Use when an emitter goes away or a voxel becomes opaque, after updating emission
+             * and opacity. Other sources fill the cleared area back in during the update.
+             */
+            void removeLight(LightVolume* volume, LightChannel channel, ui32 index) {
+                // Cleared when processed, earlier edits may still light the voxel
+                impl::LightNode node = { index, 0, impl::LIGHT_SEED, true };
+                post(volume, channel, node);
+            }
+            /*! @brief Lets the light around a voxel flow into it on every channel.
+             *
+             * Use when a voxel becomes clearer, for example when a block is broken.
+             */
+            void relight(LightVolume* volume, ui32 index) {
+                for (ui8 d = 0; d < 6; d++) {
+                    LightVolume* target = volume;
+                    ui32 n;
+                    if (!step(index, d, n)) target = volume->neighbors[d];
+                    if (!target) continue;
+                    for (size_t c = 0; c < NUM_LIGHT_CHANNELS; c++) {
+                        // No value, queued removals may still clear the neighbour
+                        impl::LightNode node = { n, 0, impl::LIGHT_SEED, false };
+                        if (target->light[c][n] > 0) post(target, (LightChannel)c, node);
+                    }
+                }
+            }
+            /*! @brief Lights every clear voxel of the top layer with full sunlight.
+             *
+             * Use for volumes at the top of the world.
+             */
+            void seedSunlight(LightVolume* volume) {
+                ui32 top = m_volume - m_layer;
+                for (ui32 i = top; i < m_volume; i++) {
+                    if (volume->opacity && volume->opacity[i] != 0) continue;
+                    impl::LightNode node = { i, m_maxLight, impl::LIGHT_SEED, false };
+                    post(volume, LightChannel::SUN, node);
+                }
+            }
+
+            /*! @brief Propagates all queued edits on the calling thread.
+             */
+            void update() {
+                Scratch* scratch = acquireScratch();
+                std::vector<LightVolume*> work;
+                work.swap(m_pending);
+                while (!work.empty()) {
+                    LightVolume* volume = work.back();
+                    work.pop_back();
+                    process(volume, *scratch, [&] (LightVolume* neighbor) {
+                        work.push_back(neighbor);
+                    });
+                }
+                releaseScratch(scratch);
+            }
+            /*! @brief Propagates all queued edits as tasks, blocking until they are done.
+             *
+             * @param threadPool: Pool that runs one task per volume with work
+             * @param priority: Lane of the tasks
+             */
+            template<typename T>
+            void update(vcore::ThreadPool<T>* threadPool, vcore::TaskPriority priority = vcore::TaskPriority::HIGH) {
+                LightJob<T> job(this, threadPool, priority);
+                std::vector<LightVolume*> work;
+                work.swap(m_pending);
+                for (auto& volume : work) job.submit(volume);
+                job.wait();
+            }
+
+            /// @return True if edits are queued
+            bool hasPendingWork() const { return !m_pending.empty(); }
+
+            /// @return Counters summed over every update since the last resetStats()
+            LightEngineStats getStats() const {
+                LightEngineStats stats;
+                for (auto& scratch : m_scratch) {
+                    stats.voxelsLit += scratch->stats.voxelsLit;
+                    stats.voxelsCleared += scratch->stats.voxelsCleared;
+                    stats.handoffs += scratch->stats.handoffs;
+                    stats.passes += scratch->stats.passes;
+                }
+                return stats;
+            }
+            void resetStats() {
+                for (auto& scratch : m_scratch) scratch->stats = LightEngineStats();
+            }
+
+            /// Getters
+            const ui32& getWidth() const { return m_width; }
+            const ui8& getMaxLight() const { return m_maxLight; }
+        private:
+            VORB_NON_COPYABLE(VoxelLightEngine);
+
+            /// Queues and outgoing mail of one thread
+            struct Scratch {
+            public:
+                Scratch(size_t capacity) : removals(capacity), adds(capacity) {
+                    // Empty
+                }
+
+                vorb::ring_buffer<impl::LightNode> removals; ///< Voxels cleared and awaiting their neighbours
+                vorb::ring_buffer<impl::LightNode> adds; ///< Voxels lit and awaiting their neighbours
+                std::vector<impl::LightNode> inbox; ///< Mail being processed
+                std::vector<impl::LightNode> outbox[6][NUM_LIGHT_CHANNELS]; ///< Steps leaving through each side
+                LightEngineStats stats; ///< Work done with this scratch
+            };
+
+            /// Runs volumes as ThreadPool tasks and tracks when they are all done
+            template<typename T>
+            class LightJob : public vcore::ITaskRecycler<T> {
+            public:
+                class LightTask : public vcore::IThreadPoolTask<T> {
+                public:
+                    LightTask(LightJob* job, LightVolume* volume, vcore::TaskPriority priority) :
+                        vcore::IThreadPoolTask<T>(false, -1, priority),
+                        m_job(job),
+                        m_volume(volume) {
+                        // Empty
+                    }
+                    virtual void execute(T* workerData) override {
+                        m_job->run(m_volume);
+                    }
+                private:
+                    LightJob* m_job;
+                    LightVolume* m_volume;
+                };
+
+                LightJob(VoxelLightEngine* engine, vcore::ThreadPool<T>* threadPool, vcore::TaskPriority priority) :
+                    m_engine(engine),
+                    m_threadPool(threadPool),
+                    m_priority(priority) {
+                    // Empty
+                }
+
+                /// Queues a task for a volume that was just marked as scheduled
+                void submit(LightVolume* volume) {
+                    m_outstanding.fetch_add(1, std::memory_order_relaxed);
+                    LightTask* task = new LightTask(this, volume, m_priority);
+                    task->setRecycler(this);
+                    m_threadPool->addTask(task);
+                }
+                void run(LightVolume* volume) {
+                    Scratch* scratch = m_engine->acquireScratch();
+                    m_engine->process(volume, *scratch, [&] (LightVolume* neighbor) {
+                        submit(neighbor);
+                    });
+                    m_engine->releaseScratch(scratch);
+                }
+                /// The worker is done with the task, so the job may end
+                virtual void recycle(vcore::IThreadPoolTask<T>* task, i32 workerIndex = -1) override {
+                    delete static_cast<LightTask*>(task);
+                    m_outstanding.fetch_sub(1, std::memory_order_release);
+                }
+                void wait() {
+                    while (m_outstanding.load(std::memory_order_acquire) != 0) std::this_thread::yield();
+                }
+            private:
+                VORB_NON_COPYABLE(LightJob);
+
+                VoxelLightEngine* m_engine;
+                vcore::ThreadPool<T>* m_threadPool;
+                vcore::TaskPriority m_priority;
+                std::atomic<size_t> m_outstanding = ATOMIC_VAR_INIT(0); ///< Tasks submitted and not recycled
+            };
+
+            /*! @brief Finds the voxel one step away.
+             *
+             * @param n: Receives the neighbour index, in the adjacent volume if the step leaves this one
+             * @return True if the neighbour lies in the same volume
+             */
+            bool step(ui32 index, ui8 direction, OUT ui32& n) const {
+                switch ((Cardinal)direction) {
+                case Cardinal::X_NEG:
+                    if (index % m_width != 0) { n = index - 1; return true; }
+                    n = index + m_width - 1; return false;
+                case Cardinal::X_POS:
+                    if (index % m_width != m_width - 1) { n = index + 1; return true; }
+                    n = index - (m_width - 1); return false;
+                case Cardinal::Y_NEG:
+                    if (index >= m_layer) { n = index - m_layer; return true; }
+                    n = index + m_volume - m_layer; return false;
+                case Cardinal::Y_POS:
+                    if (index < m_volume - m_layer) { n = index + m_layer; return true; }
+                    n = index - (m_volume - m_layer); return false;
+                case Cardinal::Z_NEG:
+                    if (index % m_layer >= m_width) { n = index - m_width; return true; }
+                    n = index + m_layer - m_width; return false;
+                default:
+                    if (index % m_layer < m_layer - m_width) { n = index + m_width; return true; }
+                    n = index - (m_layer - m_width); return false;
+                }
+            }
+
+            /// Puts a node in a volume's inbox and queues the volume
+            void post(LightVolume* volume, LightChannel channel, const impl::LightNode& node) {
+                {
+                    std::lock_guard<std::mutex> lock(volume->m_lock);
+                    volume->m_inbox[(size_t)channel].push_back(node);
+                }
+                if (!volume->m_isScheduled.exchange(true)) m_pending.push_back(volume);
+            }
+
+            template<typename F>
+            void process(LightVolume* volume, Scratch& scratch, F schedule) {
+                while (true) {
+                    scratch.stats.passes++;
+                    for (size_t c = 0; c < NUM_LIGHT_CHANNELS; c++) {
+                        {
+                            std::lock_guard<std::mutex> lock(volume->m_lock);
+                            scratch.inbox.swap(volume->m_inbox[c]);
+                        }
+                        if (scratch.inbox.empty()) continue;
+                        propagate(volume, c, scratch);
+                    }
+
+                    // Hand steps that left the volume to the neighbours
+                    for (size_t d = 0; d < 6; d++) {
+                        LightVolume* neighbor = volume->neighbors[d];
+                        bool hasMail = false;
+                        for (auto& out : scratch.outbox[d]) hasMail |= !out.empty();
+                        if (!hasMail) continue;
+                        if (neighbor) {
+                            std::lock_guard<std::mutex> lock(neighbor->m_lock);
+                            for (size_t c = 0; c < NUM_LIGHT_CHANNELS; c++) {
+                                std::vector<impl::LightNode>& out = scratch.outbox[d][c];
+                                neighbor->m_inbox[c].insert(neighbor->m_inbox[c].end(), out.begin(), out.end());
+                            }
+                        }
+                        for (auto& out : scratch.outbox[d]) out.clear();
+                        if (neighbor && !neighbor->m_isScheduled.exchange(true)) schedule(neighbor);
+                    }
+
+                    // Mail that arrived while the flag was set would otherwise be stranded
+                    volume->m_isScheduled.store(false);
+                    if (!volume->hasMail() || volume->m_isScheduled.exchange(true)) return;
+                }
+            }
+
+            /// Resolves the mail of one channel of a volume
+            void propagate(LightVolume* volume, size_t channel, Scratch& scratch) {
+                ui8* light = volume->light[channel];
+                const ui8* opacity = volume->opacity;
+                const ui8* emission = channel == (size_t)LightChannel::BLOCK ? volume->emission : nullptr;
+                bool sun = channel == (size_t)LightChannel::SUN;
+                LightEngineStats& stats = scratch.stats;
+
+                auto pushRemoval = [&] (ui32 i, ui8 value) {
+                    impl::LightNode node = { i, value, 0, false };
+                    if (!scratch.removals.push(node)) {
+                        scratch.removals.resize(scratch.removals.size() * 2);
+                        scratch.removals.push(node);
+                    }
+                };
+                auto pushAdd = [&] (ui32 i, ui8 value) {
+                    impl::LightNode node = { i, value, 0, false };
+                    if (!scratch.adds.push(node)) {
+                        scratch.adds.resize(scratch.adds.size() * 2);
+                        scratch.adds.push(node);
+                    }
+                };
+                // A neighbour that lost a source: clear it if it depended on it, else let it shine back
+                auto visitRemoval = [&] (ui32 n, ui8 value, ui8 direction) {
+                    ui8 l = light[n];
+                    if (l == 0) return;
+                    if (l < value || (sun && direction == (ui8)Cardinal::Y_NEG && l == m_maxLight && value == m_maxLight)) {
+                        light[n] = 0;
+                        stats.voxelsCleared++;
+                        pushRemoval(n, l);
+                        // Emitters are sources in their own right
+                        if (emission && emission[n] > 0) {
+                            light[n] = emission[n];
+                            pushAdd(n, emission[n]);
+                        }
+                    } else {
+                        pushAdd(n, l);
+                    }
+                };
+                auto visitAdd = [&] (ui32 n, ui8 value, ui8 direction) {
+                    ui32 o = opacity ? opacity[n] : 0;
+                    if (o >= m_maxLight) return;
+                    i32 next;
+                    if (sun && direction == (ui8)Cardinal::Y_NEG && value == m_maxLight && o == 0) {
+                        next = m_maxLight;
+                    } else {
+                        next = (i32)value - 1 - (i32)o;
+                    }
+                    if (next > (i32)light[n]) {
+                        light[n] = (ui8)next;
+                        stats.voxelsLit++;
+                        pushAdd(n, (ui8)next);
+                    }
+                };
+
+                auto runRemovals = [&] () {
+                    while (scratch.removals.size() > 0) {
+                        impl::LightNode node = scratch.removals.front();
+                        scratch.removals.pop();
+                        for (ui8 d = 0; d < 6; d++) {
+                            ui32 n;
+                            if (step(node.index, d, n)) {
+                                visitRemoval(n, node.value, d);
+                            } else if (volume->neighbors[d]) {
+                                impl::LightNode out = { n, node.value, d, true };
+                                scratch.outbox[d][channel].push_back(out);
+                                stats.handoffs++;
+                            }
+                        }
+                    }
+                };
+                auto runAdds = [&] () {
+                    while (scratch.adds.size() > 0) {
+                        impl::LightNode node = scratch.adds.front();
+                        scratch.adds.pop();
+                        // Skip voxels that were cleared or lit brighter after being queued
+                        if (light[node.index] != node.value) continue;
+                        for (ui8 d = 0; d < 6; d++) {
+                            ui32 n;
+                            if (step(node.index, d, n)) {
+                                visitAdd(n, node.value, d);
+                            } else if (volume->neighbors[d] && node.value > 1) {
+                                impl::LightNode out = { n, node.value, d, false };
+                                scratch.outbox[d][channel].push_back(out);
+                                stats.handoffs++;
+                            }
+                        }
+                    }
+                };
+
+                // Mail is handled in order, in runs of removals and adds. A removal run clears
+                // everything depending on it before any light floods back, and each sender's
+                // removals and adds keep their order, so stale light never outlives its removal.
+                bool inRemovalRun = false;
+                for (auto& node : scratch.inbox) {
+                    if (node.isRemoval != inRemovalRun) {
+                        runRemovals();
+                        if (node.isRemoval) runAdds();
+                        inRemovalRun = node.isRemoval;
+                    }
+                    if (node.isRemoval) {
+                        if (node.direction == impl::LIGHT_SEED) {
+                            ui8 l = light[node.index];
+                            if (l == 0) continue;
+                            light[node.index] = 0;
+                            stats.voxelsCleared++;
+                            pushRemoval(node.index, l);
+                        } else {
+                            visitRemoval(node.index, node.value, node.direction);
+                        }
+                    } else if (node.direction != impl::LIGHT_SEED) {
+                        visitAdd(node.index, node.value, node.direction);
+                    } else if (!opacity || opacity[node.index] < m_maxLight) {
+                        ui8 value = node.value ? node.value : light[node.index];
+                        if (value > 0 && value >= light[node.index]) {
+                            if (value > light[node.index]) stats.voxelsLit++;
+                            light[node.index] = value;
+                            pushAdd(node.index, value);
+                        }
+                    }
+                }
+                scratch.inbox.clear();
+                runRemovals();
+                runAdds();
+            }
+
+            Scratch* acquireScratch() {
+                Scratch* scratch;
+                if (m_freeScratch.try_dequeue(scratch)) return scratch;
+                scratch = new Scratch(m_volume / 8 + 64);
+                std::lock_guard<std::mutex> lock(m_scratchLock);
+                m_scratch.push_back(scratch);
+                return scratch;
+            }
+            void releaseScratch(Scratch* scratch) {
+                m_freeScratch.enqueue(scratch);
+            }
+
+            ui32 m_width; ///< Volume width
+            ui32 m_layer; ///< Voxels per Y layer
+            ui32 m_volume; ///< Voxels per volume
+            ui8 m_maxLight; ///< Strongest light level
+
+            std::vector<LightVolume*> m_pending; ///< Volumes with seeded work
+            std::vector<Scratch*> m_scratch; ///< Every scratch ever made
+            moodycamel::ConcurrentQueue<Scratch*> m_freeScratch; ///< Scratch not used by a thread
+            std::mutex m_scratchLock; ///< Guards m_scratch
+        };
+    }
+}
+namespace vvox = vorb::voxel;
+
+#endif // !Vorb_VoxelLightEngine_h__
+
+/*! \example "Voxel Light Benchmark"
+ *
+ * Measures light propagation throughput in voxels per second, serial and on a ThreadPool.
+ * \include VorbVoxelLightBench.cpp
+ */
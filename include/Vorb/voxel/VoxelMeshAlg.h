@@ -15,6 +15,14 @@
 #ifndef VoxelMeshAlg_h__
 #define VoxelMeshAlg_h__
 
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
 #include "VoxCommon.h"
 
 namespace vorb {
@@ -36,6 +44,148 @@ namespace vorb {
                 Cardinal direction; ///< Direction the quad is facing
             };
 
+            /// Per-vertex shading of a quad, corners ordered (-u, -v), (+u, -v), (-u, +v), (+u, +v)
+            struct VoxelQuadLighting {
+            public:
+                ui8 occlusion[4]; ///< Number of occluding neighbours of each corner (0-3)
+                ui8 light[4]; ///< Smoothed light of each corner
+                bool flipDiagonal; ///< Split the quad along corners 0-3 instead of 1-2
+            };
+
+            /// A VoxelQuad with its render payload, packed into 8 bytes
+            /// Layout from the lowest bit: position XYZ (6 bits each), size - 1 (6 bits each),
+            /// direction (3 bits), ambient occlusion of the four corners (2 bits each), light (8 bits)
+            /// and texture (15 bits). Meshes store one of these per quad; vertex shaders fetch it by
+            /// gl_VertexID / 4 and derive the corner from gl_VertexID % 4, drawn with QuadIndexBuffer.
+            struct PackedVoxelQuad {
+            public:
+                static const ui32 POSITION_BITS = 6; ///< Bits per position and size component
+                static const ui32 DIRECTION_SHIFT = 30; ///< First bit of the direction
+                static const ui32 AO_SHIFT = 33; ///< First bit of the corner occlusion
+                static const ui32 LIGHT_SHIFT = 41; ///< First bit of the light value
+                static const ui32 TEXTURE_SHIFT = 49; ///< First bit of the texture index
+                static const ui32 MAX_TEXTURE = (1 << 15) - 1; ///< Largest texture index
+
+                static const ui32 MAX_POSITION = (1 << POSITION_BITS) - 1; ///< Largest position component
+                static const ui32 MAX_SIZE = 1 << POSITION_BITS; ///< Largest size component
+
+                /// Pack a mesher quad. Out of range fields would bleed into their neighbours,
+                /// so meshes of regions wider than 64 voxels must be split before packing.
+                /// @param q: Quad, with positions at most MAX_POSITION and sizes from 1 to MAX_SIZE
+                /// @param texture: Texture index, at most MAX_TEXTURE
+                /// @param light: Light value of the face
+                static PackedVoxelQuad pack(const VoxelQuad& q, ui32 texture, ui8 light = 255) {
+                    assert(q.voxelPosition.x <= MAX_POSITION && q.voxelPosition.y <= MAX_POSITION && q.voxelPosition.z <= MAX_POSITION);
+                    assert(q.size.x >= 1 && q.size.x <= MAX_SIZE && q.size.y >= 1 && q.size.y <= MAX_SIZE);
+                    assert(texture <= MAX_TEXTURE);
+                    PackedVoxelQuad p;
+                    p.bits = (ui64)q.voxelPosition.x |
+                        ((ui64)q.voxelPosition.y << 6) |
+                        ((ui64)q.voxelPosition.z << 12) |
+                        ((ui64)(q.size.x - 1) << 18) |
+                        ((ui64)(q.size.y - 1) << 24) |
+                        ((ui64)q.direction << DIRECTION_SHIFT) |
+                        ((ui64)light << LIGHT_SHIFT) |
+                        ((ui64)(texture & MAX_TEXTURE) << TEXTURE_SHIFT);
+                    return p;
+                }
+
+                ui32v3 getPosition() const { return ui32v3(field(0), field(6), field(12)); }
+                ui32v2 getSize() const { return ui32v2(field(18) + 1, field(24) + 1); }
+                Cardinal getDirection() const { return (Cardinal)((bits >> DIRECTION_SHIFT) & 0x7); }
+                /// @param corner: Corner index (0-3)
+                ui32 getAO(ui32 corner) const { return (ui32)(bits >> (AO_SHIFT + corner * 2)) & 0x3; }
+                ui8 getLight() const { return (ui8)(bits >> LIGHT_SHIFT); }
+                ui32 getTexture() const { return (ui32)(bits >> TEXTURE_SHIFT); }
+
+                /// @param corner: Corner index (0-3)
+                /// @param ao: Occlusion level (0-3)
+                void setAO(ui32 corner, ui32 ao) {
+                    ui32 shift = AO_SHIFT + corner * 2;
+                    bits = (bits & ~(0x3ull << shift)) | ((ui64)(ao & 0x3) << shift);
+                }
+                void setLight(ui8 light) {
+                    bits = (bits & ~(0xFFull << LIGHT_SHIFT)) | ((ui64)light << LIGHT_SHIFT);
+                }
+
+                ui64 bits; ///< Packed fields
+            private:
+                ui32 field(ui32 shift) const { return (ui32)(bits >> shift) & ((1 << POSITION_BITS) - 1); }
+            };
+            static_assert(sizeof(PackedVoxelQuad) == 8, "PackedVoxelQuad must stay 8 bytes");
+
+            /// Quad indices shared by every mesh
+            /// The buffer only ever grows, and earlier buffers are kept alive, so a returned pointer stays
+            /// valid for the life of the program. A renderer uploads it once and again only when
+            /// getCapacity() grows, instead of generating indices for every mesh.
+            /// @tparam T: Index type/size
+            template<typename T>
+            class QuadIndexBuffer {
+                static_assert(std::is_unsigned<T>::value && sizeof(T) <= sizeof(ui32), "Quad indices must be unsigned and at most 32 bits");
+            public:
+                /// Largest number of quads the index type can address
+                static const ui64 MAX_QUADS = ((ui64)(T)~(T)0 + 1) / 4;
+
+                /// Get indices for at least the requested number of quads. Thread-safe
+                /// @param quads: Number of quads to draw, at most MAX_QUADS
+                /// @return Indices, ordered like generateQuadIndices with a start index of 0
+                /// @throws std::out_of_range if the index type cannot address the quads
+                static const T* get(ui32 quads) {
+                    if (quads > MAX_QUADS) throw std::out_of_range("QuadIndexBuffer: too many quads for the index type");
+                    Storage& s = storage();
+                    const Block* block = s.current.load(std::memory_order_acquire);
+                    if (block && block->quads >= quads) return block->indices.data();
+
+                    std::lock_guard<std::mutex> lock(s.lock);
+                    block = s.current.load(std::memory_order_relaxed);
+                    if (!block || block->quads < quads) {
+                        ui64 n = block ? block->quads : 1024;
+                        while (n < quads) n *= 2;
+                        // Still covers the request, which was checked above
+                        if (n > MAX_QUADS) n = MAX_QUADS;
+
+                        Block* grown = new Block;
+                        grown->quads = (ui32)n;
+                        grown->indices.resize((size_t)n * 6);
+                        T vi = 0;
+                        for (size_t ii = 0; ii < grown->indices.size(); vi += 4) {
+                            grown->indices[ii++] = vi;
+                            grown->indices[ii++] = vi + 2;
+                            grown->indices[ii++] = vi + 1;
+                            grown->indices[ii++] = vi + 1;
+                            grown->indices[ii++] = vi + 2;
+                            grown->indices[ii++] = vi + 3;
+                        }
+                        s.blocks.emplace_back(grown);
+                        s.current.store(grown, std::memory_order_release);
+                        block = grown;
+                    }
+                    return block->indices.data();
+                }
+
+                /// @return Number of quads covered by the current buffer
+                static ui32 getCapacity() {
+                    const Block* block = storage().current.load(std::memory_order_acquire);
+                    return block ? block->quads : 0;
+                }
+            private:
+                struct Block {
+                public:
+                    ui32 quads; ///< Quads covered
+                    std::vector<T> indices; ///< Six indices per quad
+                };
+                struct Storage {
+                public:
+                    std::atomic<const Block*> current = ATOMIC_VAR_INIT(nullptr); ///< Largest buffer
+                    std::vector<std::unique_ptr<Block> > blocks; ///< Every buffer handed out so far
+                    std::mutex lock; ///< Guards growth
+                };
+                static Storage& storage() {
+                    static Storage s;
+                    return s;
+                }
+            };
+
             /// Create an index list for quads
             /// @tparam T: Index type/size
             /// @param quads: Number of quads for which indices must be specified
@@ -15,6 +15,12 @@
 #ifndef VoxelMesher_h__
 #define VoxelMesher_h__
 
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include "../BitUtils.h"
 #include "VoxCommon.h"
 #include "VoxelMeshAlg.h"
 
@@ -76,9 +82,405 @@ namespace vorb {
                     }
                 }
             }
+
+            namespace impl {
+                /// Sweep axes (face normal, u, v) of each axis, shared by the greedy algorithms
+                inline const ui32v3& getSweep(size_t axis) {
+                    static const ui32v3 SWEEPS[3] = {
+                        ui32v3(0, 2, 1),
+                        ui32v3(1, 0, 2),
+                        ui32v3(2, 0, 1)
+                    };
+                    return SWEEPS[axis];
+                }
+
+                /// Greedily mesh the faces between layers f - 1 and f of one axis
+                /// @param masks: Scratch for face owners of both directions
+                /// @param emit: Callable as emit(const VoxelQuad&)
+                template<typename T, typename API, typename Equal, typename Emit>
+                inline void greedySlice(const T* data, const ui32v3& size, API* api, size_t axis, ui32 f,
+                                        std::vector<ui32> (&masks)[2], const Equal& equal, Emit emit) {
+                    static Axis AXES[3] = {
+                        Axis::X,
+                        Axis::Y,
+                        Axis::Z
+                    };
+                    const ui32 NO_FACE = 0xFFFFFFFFu;
+
+                    const ui32v3& sweep = getSweep(axis);
+                    ui32v3 sizes(size[sweep.x], size[sweep.y], size[sweep.z]);
+                    if (sizes.y < 3 || sizes.z < 3) return;
+                    ui32 nu = sizes.y - 2;
+                    ui32 nv = sizes.z - 2;
+                    masks[0].resize(nu * nv);
+                    masks[1].resize(nu * nv);
+
+                    size_t l1 = size.x;
+                    size_t l2 = l1 * size.z;
+                    ui32v3 pos;
+                    ui32& fAxis = pos[sweep.x];
+                    ui32& uAxis = pos[sweep.y];
+                    ui32& vAxis = pos[sweep.z];
+
+                    // Find the visible faces between slices f - 1 and f
+                    ui32* m = &masks[0][0];
+                    ui32* n = &masks[1][0];
+                    for (vAxis = 1; vAxis < sizes.z - 1; vAxis++) {
+                        for (uAxis = 1; uAxis < sizes.y - 1; uAxis++) {
+                            fAxis = f - 1;
+                            ui32 i1 = (ui32)(pos.y * l2 + pos.z * l1 + pos.x);
+                            fAxis = f;
+                            ui32 i2 = (ui32)(pos.y * l2 + pos.z * l1 + pos.x);
+
+                            VoxelFaces faces = api->occludes(data[i1], data[i2], AXES[axis]);
+                            *m++ = (faces.block1Face && f != 1) ? i1 : NO_FACE;
+                            *n++ = (faces.block2Face && f != sizes.x - 1) ? i2 : NO_FACE;
+                        }
+                    }
+
+                    // Grow rectangles, first along u and then along v
+                    for (size_t d = 0; d < 2; d++) {
+                        std::vector<ui32>& mask = masks[d];
+                        VoxelQuad q;
+                        q.direction = toCardinal(AXES[axis], d == 0);
+                        fAxis = d == 0 ? f - 1 : f;
+
+                        for (ui32 v = 0; v < nv; v++) {
+                            for (ui32 u = 0; u < nu; u++) {
+                                ui32 owner = mask[v * nu + u];
+                                if (owner == NO_FACE) continue;
+                                const T& voxel = data[owner];
+
+                                ui32 w = 1;
+                                while (u + w < nu && mask[v * nu + u + w] != NO_FACE && equal(data[mask[v * nu + u + w]], voxel)) w++;
+                                ui32 h = 1;
+                                for (; v + h < nv; h++) {
+                                    ui32* row = &mask[(v + h) * nu + u];
+                                    ui32 i = 0;
+                                    while (i < w && row[i] != NO_FACE && equal(data[row[i]], voxel)) i++;
+                                    if (i < w) break;
+                                }
+                                for (ui32 j = 0; j < h; j++) {
+                                    for (ui32 i = 0; i < w; i++) mask[(v + j) * nu + u + i] = NO_FACE;
+                                }
+
+                                uAxis = u + 1;
+                                vAxis = v + 1;
+                                q.voxelPosition = pos;
+                                q.startIndex = owner;
+                                q.size = ui32v2(w, h);
+                                emit(q);
+                            }
+                        }
+                    }
+                }
+
+                /// Orders quads for matching old and new output
+                inline bool quadLess(const VoxelQuad& a, const VoxelQuad& b) {
+                    if (a.startIndex != b.startIndex) return a.startIndex < b.startIndex;
+                    if (a.direction != b.direction) return a.direction < b.direction;
+                    if (a.size.x != b.size.x) return a.size.x < b.size.x;
+                    return a.size.y < b.size.y;
+                }
+            }
+
+            /// Construct a voxel mesh like createCulled, but merge visible coplanar faces into maximal rectangles
+            /// Faces merge when the voxels that own them compare equal, so anything that must split a quad
+            /// (texture, lighting) has to be part of that comparison. Quad sizes are measured along the two
+            /// axes spanning the face: (Z, Y) for X faces, (X, Z) for Y faces and (X, Y) for Z faces.
+            /// @tparam T: Voxel data type
+            /// @tparam API: Type of API object that handles culled meshing
+            /// @tparam Equal: Comparison deciding if two faces may share a quad
+            /// @param data: 3D array of voxel data accessed Y-Z-X
+            /// @param size: Sizes of array (XYZ)
+            /// @param api: API object
+            /// @param equal: Face comparison object
+            template<typename T, typename API, typename Equal = std::equal_to<T> >
+            inline void createGreedy(const T* data, const ui32v3& size, API* api, Equal equal = Equal()) {
+                std::vector<ui32> masks[2];
+                for (size_t axis = 0; axis < 3; axis++) {
+                    ui32 layers = size[impl::getSweep(axis).x];
+                    for (ui32 f = 1; f < layers; f++) {
+                        impl::greedySlice(data, size, api, axis, f, masks, equal, [api] (const VoxelQuad& q) {
+                            api->result(q);
+                        });
+                    }
+                }
+            }
+
+            /// Changes made to a quad list by remeshGreedy
+            struct VoxelMeshDiff {
+            public:
+                std::vector<VoxelQuad> removed; ///< Quads that are no longer part of the mesh
+                std::vector<VoxelQuad> added; ///< Quads that were appended to the mesh
+            };
+
+            /// Update a createGreedy mesh after the voxels in a box changed
+            /// Only the slices whose faces can see a changed voxel are meshed again: along each axis, the
+            /// layer pairs touching the box. Old quads from those slices that come out again unchanged stay
+            /// where they are; the rest are removed and the new ones appended, so the diff is minimal.
+            /// Passing an equal that never matches keeps quads 1x1, which updates createCulled output.
+            /// @param data: 3D array of voxel data accessed Y-Z-X, already containing the edit
+            /// @param size: Sizes of array (XYZ)
+            /// @param api: API object, only occludes() is called
+            /// @param dirtyMin: Lowest changed voxel (XYZ)
+            /// @param dirtyMax: Highest changed voxel (XYZ), inclusive
+            /// @param quads: The current mesh, updated in place
+            /// @param diff: Receives the removed and added quads
+            /// @param equal: Face comparison object, must match the one the mesh was made with
+            template<typename T, typename API, typename Equal = std::equal_to<T> >
+            inline void remeshGreedy(const T* data, const ui32v3& size, API* api, const ui32v3& dirtyMin, const ui32v3& dirtyMax,
+                                     std::vector<VoxelQuad>& quads, OUT VoxelMeshDiff& diff, Equal equal = Equal()) {
+                diff.removed.clear();
+                diff.added.clear();
+
+                // Pair slices f = (f - 1, f) that see the box, per axis
+                ui32 first[3], last[3];
+                for (size_t axis = 0; axis < 3; axis++) {
+                    ui32 a = impl::getSweep(axis).x;
+                    first[axis] = std::max(dirtyMin[a], 1u);
+                    last[axis] = std::min(dirtyMax[a] + 1, size[a] - 1);
+                }
+                auto isAffected = [&] (const VoxelQuad& q) {
+                    size_t axis = (size_t)q.direction >> 1;
+                    ui32 layer = q.voxelPosition[impl::getSweep(axis).x];
+                    // Positive faces belong to the slice above their voxel
+                    ui32 f = ((ui32)q.direction & 1) ? layer + 1 : layer;
+                    return f >= first[axis] && f <= last[axis];
+                };
+
+                // Mesh the affected slices again
+                std::vector<VoxelQuad>& fresh = diff.added;
+                std::vector<ui32> masks[2];
+                for (size_t axis = 0; axis < 3; axis++) {
+                    for (ui32 f = first[axis]; f <= last[axis]; f++) {
+                        impl::greedySlice(data, size, api, axis, f, masks, equal, [&fresh] (const VoxelQuad& q) {
+                            fresh.push_back(q);
+                        });
+                    }
+                }
+                std::sort(fresh.begin(), fresh.end(), impl::quadLess);
+                std::vector<bool> matched(fresh.size(), false);
+
+                // Keep unaffected and unchanged quads in order, drop the others
+                size_t kept = 0;
+                for (size_t i = 0; i < quads.size(); i++) {
+                    const VoxelQuad& q = quads[i];
+                    if (isAffected(q)) {
+                        auto it = std::lower_bound(fresh.begin(), fresh.end(), q, impl::quadLess);
+                        size_t m = it - fresh.begin();
+                        if (it == fresh.end() || impl::quadLess(q, *it) || matched[m]) {
+                            diff.removed.push_back(q);
+                            continue;
+                        }
+                        matched[m] = true;
+                    }
+                    quads[kept++] = q;
+                }
+                quads.resize(kept);
+
+                // Whatever was not matched is new
+                size_t added = 0;
+                for (size_t i = 0; i < fresh.size(); i++) {
+                    if (matched[i]) continue;
+                    fresh[added++] = fresh[i];
+                    quads.push_back(fresh[i]);
+                }
+                fresh.resize(added);
+            }
+
+            namespace impl {
+                /// Opacity of a voxel block, one bit per voxel in 64-bit words along X
+                class OpacityRows {
+                public:
+                    template<typename T, typename API>
+                    void build(const T* data, const ui32v3& size, API* api) {
+                        m_size = size;
+                        m_words = (size.x + 63) / 64;
+                        m_bits.assign(m_words * size.z * size.y, 0);
+                        for (size_t row = 0; row < size.z * size.y; row++) {
+                            const T* src = data + row * size.x;
+                            ui64* dst = &m_bits[row * m_words];
+                            for (size_t x = 0; x < size.x; x++) {
+                                if (api->isOpaque(src[x])) dst[x >> 6] |= 1ull << (x & 63);
+                            }
+                        }
+                    }
+
+                    const ui64* getRow(size_t y, size_t z) const { return &m_bits[(y * m_size.z + z) * m_words]; }
+                    bool isOpaque(const ui32v3& p) const { return ((getRow(p.y, p.z)[p.x >> 6] >> (p.x & 63)) & 1) != 0; }
+                    const size_t& getWords() const { return m_words; }
+                private:
+                    ui32v3 m_size;
+                    size_t m_words = 0;
+                    std::vector<ui64> m_bits;
+                };
+
+                /// Hand an unlit face to the API
+                template<typename T, typename API>
+                inline void emitFace(const T* data, const ui32v3& size, const OpacityRows& opacity, API* api, const VoxelQuad& q, std::false_type) {
+                    api->result(q);
+                }
+                /// Sample occlusion and light around a face and hand both to the API
+                template<typename T, typename API>
+                inline void emitFace(const T* data, const ui32v3& size, const OpacityRows& opacity, API* api, const VoxelQuad& q, std::true_type) {
+                    // Tangents match the quad size axes of createGreedy
+                    static const ui32 TANGENTS[3][2] = {
+                        { 2, 1 },
+                        { 0, 2 },
+                        { 0, 1 }
+                    };
+                    ui32 axis = (ui32)q.direction >> 1;
+                    ui32v3 front = q.voxelPosition;
+                    if (((ui32)q.direction & 1) != 0) {
+                        front[axis]++;
+                    } else {
+                        front[axis]--;
+                    }
+
+                    // The 3x3 neighbourhood in front of the face
+                    bool solid[3][3];
+                    ui32 light[3][3];
+                    ui32 u = TANGENTS[axis][0];
+                    ui32 v = TANGENTS[axis][1];
+                    for (i32 j = 0; j < 3; j++) {
+                        for (i32 i = 0; i < 3; i++) {
+                            ui32v3 p = front;
+                            p[u] += i - 1;
+                            p[v] += j - 1;
+                            solid[j][i] = opacity.isOpaque(p);
+                            light[j][i] = solid[j][i] ? 0 : api->getLight(data[(p.y * size.z + p.z) * size.x + p.x]);
+                        }
+                    }
+
+                    VoxelQuadLighting lighting;
+                    for (ui32 c = 0; c < 4; c++) {
+                        ui32 i = (c & 1) ? 2 : 0;
+                        ui32 j = (c & 2) ? 2 : 0;
+                        bool side1 = solid[1][i];
+                        bool side2 = solid[j][1];
+                        bool corner = solid[j][i];
+                        lighting.occlusion[c] = (side1 && side2) ? 3 : (ui8)(side1 + side2 + corner);
+
+                        // Average the light of the open voxels touching the corner
+                        ui32 sum = light[1][1];
+                        ui32 count = 1;
+                        if (!side1) {
+                            sum += light[1][i];
+                            count++;
+                        }
+                        if (!side2) {
+                            sum += light[j][1];
+                            count++;
+                        }
+                        if (!corner && !(side1 && side2)) {
+                            sum += light[j][i];
+                            count++;
+                        }
+                        lighting.light[c] = (ui8)(sum / count);
+                    }
+                    // Split along the brighter diagonal, otherwise occlusion smears across the quad
+                    lighting.flipDiagonal = lighting.occlusion[0] + lighting.occlusion[3] < lighting.occlusion[1] + lighting.occlusion[2];
+                    api->result(q, lighting);
+                }
+
+                template<typename T, typename API, typename Lit>
+                inline void createCulledBitmask(const T* data, const ui32v3& size, API* api, Lit lit) {
+                    if (size.x < 3 || size.y < 3 || size.z < 3) return;
+
+                    size_t l1 = size.x;
+                    size_t l2 = l1 * size.z;
+
+                    OpacityRows opacity;
+                    opacity.build(data, size, api);
+                    size_t words = opacity.getWords();
+
+                    VoxelQuad q;
+                    q.size = ui32v2(1, 1);
+                    ui64 faces[6];
+                    for (ui32 y = 1; y < size.y - 1; y++) {
+                        for (ui32 z = 1; z < size.z - 1; z++) {
+                            const ui64* row = opacity.getRow(y, z);
+                            const ui64* yNeg = opacity.getRow(y - 1, z);
+                            const ui64* yPos = opacity.getRow(y + 1, z);
+                            const ui64* zNeg = opacity.getRow(y, z - 1);
+                            const ui64* zPos = opacity.getRow(y, z + 1);
+
+                            for (size_t w = 0; w < words; w++) {
+                                ui64 r = row[w];
+                                // Only interior voxels emit faces
+                                ui64 interior = ~0ull;
+                                if (w == 0) interior &= ~1ull;
+                                size_t last = size.x - 1 - w * 64;
+                                if (last < 64) interior &= (1ull << last) - 1;
+                                r &= interior;
+                                if (r == 0) continue;
+
+                                // Carry neighbours across word boundaries
+                                ui64 right = (row[w] >> 1) | (w + 1 < words ? row[w + 1] << 63 : 0);
+                                ui64 left = (row[w] << 1) | (w > 0 ? row[w - 1] >> 63 : 0);
+                                faces[(size_t)Cardinal::X_NEG] = r & ~left;
+                                faces[(size_t)Cardinal::X_POS] = r & ~right;
+                                faces[(size_t)Cardinal::Y_NEG] = r & ~yNeg[w];
+                                faces[(size_t)Cardinal::Y_POS] = r & ~yPos[w];
+                                faces[(size_t)Cardinal::Z_NEG] = r & ~zNeg[w];
+                                faces[(size_t)Cardinal::Z_POS] = r & ~zPos[w];
+
+                                for (size_t c = 0; c < 6; c++) {
+                                    q.direction = (Cardinal)c;
+                                    ui64 bits = faces[c];
+                                    while (bits) {
+                                        ui32 x = (ui32)(w * 64) + vorb::lowestSetBit(bits);
+                                        bits &= bits - 1;
+                                        q.voxelPosition = ui32v3(x, y, z);
+                                        q.startIndex = (ui32)(y * l2 + z * l1 + x);
+                                        emitFace(data, size, opacity, api, q, lit);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            /// Construct the same faces as createCulled from an opacity predicate, 64 voxels at a time
+            /// Opacity is gathered into one bit per voxel, with rows running along X. A face is visible when
+            /// its voxel is opaque and the neighbour is not, which is found for whole rows with shifts and
+            /// AND-NOT. Only set bits reach the API, so mostly solid or mostly empty chunks are cheap.
+            /// @tparam T: Voxel data type
+            /// @tparam API: Type with bool isOpaque(const T&) and result(const VoxelQuad&)
+            /// @param data: 3D array of voxel data accessed Y-Z-X
+            /// @param size: Sizes of array (XYZ)
+            /// @param api: API object
+            template<typename T, typename API>
+            inline void createCulledBitmask(const T* data, const ui32v3& size, API* api) {
+                impl::createCulledBitmask(data, size, api, std::false_type());
+            }
+            /// Like createCulledBitmask, but also compute per-vertex ambient occlusion and smooth light
+            /// Each face samples the 3x3 voxels in front of it: corners are occluded by their two side
+            /// neighbours and the diagonal one, and take the average light of the open voxels touching
+            /// them. The opacity bits are reused, so this costs no extra pass over the chunk. Voxels on
+            /// the border layer are sampled, so data should be a padded block.
+            /// @tparam T: Voxel data type
+            /// @tparam API: Type with bool isOpaque(const T&), ui8 getLight(const T&) and
+            /// result(const VoxelQuad&, const VoxelQuadLighting&)
+            /// @param data: 3D array of voxel data accessed Y-Z-X
+            /// @param size: Sizes of array (XYZ)
+            /// @param api: API object
+            template<typename T, typename API>
+            inline void createCulledBitmaskLit(const T* data, const ui32v3& size, API* api) {
+                impl::createCulledBitmask(data, size, api, std::true_type());
+            }
         }
     }
 }
 namespace vvox = vorb::voxel;
 
-#endif // VoxelMesher_h__
\ No newline at end of file
+#endif // VoxelMesher_h__
+
+/*! \example "Culled and Greedy Voxel Meshing"
+ *
+ * Compares quad counts and meshing time of createCulled, createCulledBitmask and
+ * createGreedy on synthetic terrain.
+ * \include VorbVoxelMesherBench.cpp
+ */
\ No newline at end of file
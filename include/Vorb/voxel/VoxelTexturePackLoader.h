@@ -0,0 +1,320 @@
+//
+// VoxelTexturePackLoader.h
+// Vorb Engine
+//
+// Created by agent on 17 Oct 2026
+// Copyright 2014 Regrowth Studios
+// All Rights Reserved
+//
+
+/*! \file VoxelTexturePackLoader.h
+ * @brief Loads voxel tile textures in parallel and builds their atlas pages.
+ */
+
+#pragma once
+
+#ifndef Vorb_VoxelTexturePackLoader_h__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_VoxelTexturePackLoader_h__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "types.h"
+#endif // !VORB_USING_PCH
+
+#include "../Events.hpp"
+#include "../ThreadPool.h"
+#include "../graphics/GpuMemory.h"
+#include "../graphics/ImageIO.h"
+#include "../graphics/SamplerState.h"
+#include "../io/Path.h"
+#include "VoxelTextureStitcher.h"
+
+namespace vorb {
+    namespace voxel {
+        /*! @brief Where a texture pack load currently stands.
+         */
+        struct TexturePackProgress {
+        public:
+            size_t total = 0; ///< Textures in the load
+            size_t decoded = 0; ///< Textures decoded by the workers
+            size_t stitched = 0; ///< Textures copied into their atlas page
+            size_t pages = 0; ///< Atlas pages in use
+            size_t pagesUploaded = 0; ///< Atlas pages uploaded to the GPU
+        };
+
+        /*! @brief Builds a voxel texture atlas from image files using a ThreadPool.
+         *
+         * Images are decoded on the workers, which is where nearly all of the time goes for a
+         * large resource pack. Everything else happens in update(), which must be called on the
+         * GL thread: decoded images are mapped through the stitcher in the order they were added,
+         * so indices do not depend on thread timing, then copied into CPU-side pages. Once every
+         * image is stitched, the pages are uploaded through GpuMemory, a few per update() so a
+         * frame never stalls on a whole pack. Events are also sent from update() only.
+         *
+         * An image of w x h tiles of the tile resolution is mapped as a single tile or a box.
+         * Images that fail to load or fit on no page get index 0, the null texture.
+         *
+         * @tparam T: Worker data type of the ThreadPool
+         * @tparam Stitcher: Index mapper, VoxelTextureStitcher or VoxelAtlasPacker
+         */
+        template<typename T, typename Stitcher = VoxelTextureStitcher>
+        class VoxelTexturePackLoader {
+        public:
+            /*! @param stitcher: Maps textures to atlas indices, must outlive the loader
+             * @param resolution: Width and height of a tile in pixels
+             * @param pagesPerUpdate: Maximum pages uploaded by one update()
+             * @param sampler: Sampler state of the page textures
+             */
+            VoxelTexturePackLoader(Stitcher* stitcher, ui32 resolution, size_t pagesPerUpdate = 2,
+                                   vg::SamplerState* sampler = &vg::SamplerState::POINT_WRAP_MIPMAP) :
+                m_stitcher(stitcher),
+                m_resolution(resolution),
+                m_pageWidth(stitcher->getTilesPerRow() * resolution),
+                m_pagesPerUpdate(pagesPerUpdate > 0 ? pagesPerUpdate : 1),
+                m_sampler(sampler) {
+                // Empty
+            }
+            ~VoxelTexturePackLoader() {
+                // Workers may still be writing into the tasks
+                waitForDecodes();
+                freeBitmaps();
+            }
+
+            /*! @brief Queues an image for the next start().
+             *
+             * @param path: Image file, decoded as RGBA_UI8
+             * @return Handle to retrieve the atlas index with getIndex()
+             */
+            size_t addTexture(const vio::Path& path) {
+                if (isLoading()) throw std::runtime_error("Textures may not be added while a pack is loading");
+                m_paths.push_back(path);
+                return m_paths.size() - 1;
+            }
+
+            /*! @brief Submits one decode task per queued image.
+             *
+             * @param threadPool: Pool whose workers decode the images
+             * @param priority: Lane of the decode tasks
+             */
+            void start(vcore::ThreadPool<T>* threadPool, vcore::TaskPriority priority = vcore::TaskPriority::NORMAL) {
+                if (isLoading()) return;
+                waitForDecodes();
+                freeBitmaps();
+
+                size_t n = m_paths.size();
+                m_tasks.reset(new DecodeTask[n]);
+                m_numTasks = n;
+                m_indices.assign(n, 0);
+                m_nextStitch = 0;
+                m_numDecoded.store(0, std::memory_order_relaxed);
+                m_progress = TexturePackProgress();
+                m_progress.total = n;
+                m_progress.pages = m_pages.size();
+
+                std::vector<vcore::IThreadPoolTask<T>*> tasks(n);
+                for (size_t i = 0; i < n; i++) {
+                    m_tasks[i].path = m_paths[i];
+                    m_tasks[i].numDecoded = &m_numDecoded;
+                    m_tasks[i].setPriority(priority);
+                    m_tasks[i].setRecycler(&m_recycler);
+                    tasks[i] = &m_tasks[i];
+                }
+                m_isLoading = true;
+                threadPool->addTasks(tasks.data(), n);
+            }
+
+            /*! @brief Stitches decoded images and uploads finished pages. Call on the GL thread.
+             *
+             * @return True once the whole pack is on the GPU
+             */
+            bool update() {
+                if (!m_isLoading) return true;
+                TexturePackProgress previous = m_progress;
+
+                // Stitch in submission order
+                while (m_nextStitch < m_numTasks && m_tasks[m_nextStitch].decoded.load(std::memory_order_acquire)) {
+                    stitch(m_nextStitch++);
+                }
+                m_progress.decoded = m_numDecoded.load(std::memory_order_relaxed);
+                m_progress.stitched = m_nextStitch;
+
+                // Pages only go up once complete, so each is uploaded once per load
+                if (m_nextStitch == m_numTasks) {
+                    for (size_t n = 0; n < m_pagesPerUpdate && m_uploadCursor < m_pages.size(); m_uploadCursor++) {
+                        if (!m_pageDirty[m_uploadCursor]) continue;
+                        upload(m_uploadCursor);
+                        m_pageDirty[m_uploadCursor] = false;
+                        m_progress.pagesUploaded++;
+                        n++;
+                    }
+                    if (m_uploadCursor == m_pages.size()) {
+                        m_isLoading = false;
+                        m_paths.clear();
+                    }
+                }
+
+                if (m_progress.decoded != previous.decoded || m_progress.stitched != previous.stitched ||
+                    m_progress.pagesUploaded != previous.pagesUploaded || !m_isLoading) {
+                    onProgress(m_progress);
+                }
+                return !m_isLoading;
+            }
+
+            /*! @brief Frees pages, page textures and pending images. Call on the GL thread.
+             */
+            void dispose() {
+                waitForDecodes();
+                freeBitmaps();
+                for (auto& texture : m_pageTextures) {
+                    if (texture) vg::GpuMemory::freeTexture(texture);
+                }
+                std::vector<VGTexture>().swap(m_pageTextures);
+                std::vector<std::vector<ui8> >().swap(m_pages);
+                std::vector<bool>().swap(m_pageDirty);
+                std::vector<vio::Path>().swap(m_paths);
+                std::vector<ui32>().swap(m_indices);
+                m_isLoading = false;
+            }
+
+            /*! @param handle: Value returned by addTexture()
+             * @return Atlas index of the texture, valid once it is stitched
+             */
+            const ui32& getIndex(size_t handle) const { return m_indices[handle]; }
+            /*! @param page: Atlas page
+             * @return RGBA_UI8 pixels of the page, getPageWidth() squared
+             */
+            const ui8* getPageData(size_t page) const { return m_pages[page].data(); }
+            /*! @param page: Atlas page
+             * @return Texture of the page, 0 until it is uploaded
+             */
+            VGTexture getPageTexture(size_t page) const { return page < m_pageTextures.size() ? m_pageTextures[page] : 0; }
+            const TexturePackProgress& getProgress() const { return m_progress; }
+            const ui32& getPageWidth() const { return m_pageWidth; }
+            const bool& isLoading() const { return m_isLoading; }
+
+            Event<const TexturePackProgress&> onProgress; ///< Sent by update() whenever the load moves on
+            Event<const nString&> onError; ///< Sent by update() for every image that could not be used
+        private:
+            VORB_NON_COPYABLE(VoxelTexturePackLoader);
+
+            /// Decodes one image on a worker
+            class DecodeTask : public vcore::IThreadPoolTask<T> {
+            public:
+                virtual void execute(T* workerData) override {
+                    vg::ImageIO io;
+                    bitmap = io.load(path, vg::ImageIOFormat::RGBA_UI8);
+                    numDecoded->fetch_add(1, std::memory_order_relaxed);
+                    decoded.store(true, std::memory_order_release);
+                }
+
+                vio::Path path; ///< Image file
+                std::atomic<size_t>* numDecoded = nullptr; ///< Counter of the loader
+                vg::BitmapResource bitmap; ///< Decoded pixels, null if loading failed
+                std::atomic<bool> decoded = ATOMIC_VAR_INIT(false); ///< Set once bitmap may be read
+            };
+            /// Counts tasks the workers are done with. Recycling is the last time a worker
+            /// touches a task, so tasks may only be freed once all of them were recycled.
+            class DecodeRecycler : public vcore::ITaskRecycler<T> {
+            public:
+                virtual void recycle(vcore::IThreadPoolTask<T>* task, i32 workerIndex = -1) override {
+                    numRecycled.fetch_add(1, std::memory_order_release);
+                }
+
+                std::atomic<size_t> numRecycled = ATOMIC_VAR_INIT(0); ///< Recycled tasks of the current load
+            };
+
+            /// Maps a decoded image and copies it into its page
+            void stitch(size_t i) {
+                vg::BitmapResource& bitmap = m_tasks[i].bitmap;
+                ui32 width = bitmap.width / m_resolution;
+                ui32 height = bitmap.height / m_resolution;
+                if (!bitmap.data || width == 0 || height == 0 || bitmap.width % m_resolution || bitmap.height % m_resolution ||
+                    width > m_stitcher->getTilesPerRow() || height > m_stitcher->getTilesPerRow()) {
+                    onError(m_tasks[i].path.getString());
+                    if (bitmap.data) vg::ImageIO::free(bitmap);
+                    return;
+                }
+
+                ui32 index = width == 1 && height == 1 ? m_stitcher->mapSingle() : m_stitcher->mapBox(width, height);
+                m_indices[i] = index;
+                ui32 page = index / m_stitcher->getTilesPerPage();
+                ui32 tile = index % m_stitcher->getTilesPerPage();
+                while (m_pages.size() <= page) {
+                    m_pages.emplace_back((size_t)m_pageWidth * m_pageWidth * 4, (ui8)0);
+                    m_pageDirty.push_back(false);
+                }
+                m_pageDirty[page] = true;
+                m_progress.pages = m_pages.size();
+
+                // Copy row by row to the top-left corner of the box
+                size_t rowBytes = (size_t)bitmap.width * 4;
+                ui8* dst = m_pages[page].data() + (((size_t)(tile / m_stitcher->getTilesPerRow()) * m_resolution * m_pageWidth) +
+                                                   (tile % m_stitcher->getTilesPerRow()) * m_resolution) * 4;
+                for (ui32 y = 0; y < bitmap.height; y++) {
+                    memcpy(dst + (size_t)y * m_pageWidth * 4, bitmap.bytesUI8 + y * rowBytes, rowBytes);
+                }
+                vg::ImageIO::free(bitmap);
+            }
+
+            void upload(size_t page) {
+                if (m_pageTextures.size() <= page) m_pageTextures.resize(page + 1, 0);
+                VGTexture& texture = m_pageTextures[page];
+                if (texture) {
+                    vg::GpuMemory::uploadTexture(texture, m_pages[page].data(), m_pageWidth, m_pageWidth,
+                                                 vg::TexturePixelType::UNSIGNED_BYTE, vg::TextureTarget::TEXTURE_2D, m_sampler);
+                } else {
+                    texture = vg::GpuMemory::uploadTexture(m_pages[page].data(), m_pageWidth, m_pageWidth,
+                                                           vg::TexturePixelType::UNSIGNED_BYTE, vg::TextureTarget::TEXTURE_2D, m_sampler);
+                }
+            }
+
+            /// Blocks until no worker references a task
+            void waitForDecodes() {
+                while (m_recycler.numRecycled.load(std::memory_order_acquire) != m_numTasks) std::this_thread::yield();
+            }
+            /// Frees images that were decoded but never stitched
+            void freeBitmaps() {
+                for (size_t i = m_nextStitch; i < m_numTasks; i++) {
+                    if (m_tasks[i].bitmap.data) vg::ImageIO::free(m_tasks[i].bitmap);
+                }
+                m_tasks.reset();
+                m_numTasks = 0;
+                m_recycler.numRecycled.store(0, std::memory_order_relaxed);
+                m_nextStitch = 0;
+                m_uploadCursor = 0;
+            }
+
+            Stitcher* m_stitcher; ///< Index mapper
+            ui32 m_resolution; ///< Tile size in pixels
+            ui32 m_pageWidth; ///< Page size in pixels
+            size_t m_pagesPerUpdate; ///< Upload budget of update()
+            vg::SamplerState* m_sampler; ///< Sampler of page textures
+
+            std::vector<vio::Path> m_paths; ///< Images of the next or current load
+            std::unique_ptr<DecodeTask[]> m_tasks; ///< One task per image of the current load
+            size_t m_numTasks = 0; ///< Size of m_tasks
+            DecodeRecycler m_recycler; ///< Tracks when the workers let go of m_tasks
+            size_t m_nextStitch = 0; ///< First image that is not stitched yet
+            std::atomic<size_t> m_numDecoded = ATOMIC_VAR_INIT(0); ///< Images finished by the workers
+            std::vector<ui32> m_indices; ///< Atlas index of each image
+
+            std::vector<std::vector<ui8> > m_pages; ///< CPU-side RGBA_UI8 pages
+            std::vector<bool> m_pageDirty; ///< Pages changed since they were uploaded
+            size_t m_uploadCursor = 0; ///< First page update() has not checked for upload
+            std::vector<VGTexture> m_pageTextures; ///< GPU copy of each page
+            TexturePackProgress m_progress; ///< Progress of the current load
+            bool m_isLoading = false; ///< True between start() and the last upload
+        };
+    }
+}
+namespace vvox = vorb::voxel;
+
+#endif // !Vorb_VoxelTexturePackLoader_h__
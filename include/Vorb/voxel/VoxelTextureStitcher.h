@@ -28,6 +28,9 @@
 class BlockAtlasPage;
 
 /*! @brief Maps textures into a texture atlas
+*
+* For atlases with many mixed-size textures, or that need textures removed at runtime,
+* see VoxelAtlasPacker, which hands out the same indices.
 */
 namespace vorb {
     namespace voxel {